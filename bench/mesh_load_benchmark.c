@@ -0,0 +1,238 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include "depth_buffer.h"
+#include "graphics.h"
+#include "matrix.h"
+#include "mesh_cache.h"
+#include "packed_mesh.h"
+#include "meshes/normal_mesh.h"
+#include "pipelines/packed_phong_pipeline.h"
+#include "pipelines/phong_pipeline.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Times `normal_mesh_load_from_file` on each file given on the command line, or on the bundled models and a few
+// generated grids when run without arguments from the build directory. "cold" loads delete the mesh cache first.
+// "misses" are the mesh optimizer's average cache line misses per triangle, before and after it reordered the mesh.
+//
+// Each mesh is then packed (see `mesh_pack`), and its vertex memory and the time to draw it filling most of the screen
+// are compared with the unpacked mesh's.
+
+#define NUM_RUNS  3
+#define NUM_DRAWS 10
+
+#define SCREEN_WIDTH  640
+#define SCREEN_HEIGHT 480
+
+static const char* default_models[] = { "resources/teapot.obj", "resources/suzanne.obj" };
+static const size_t default_grid_sizes[] = { 100, 300, 708 };
+
+static double get_time(void);
+static bool write_grid(const char* path, size_t size);
+static void remove_cache(const char* path);
+static bool time_load(const char* path,
+                      bool cold,
+                      double* seconds,
+                      size_t* num_triangles,
+                      MeshOptimizationStats* optimization);
+static bool benchmark(const char* path);
+static bool benchmark_packed(const char* path);
+
+int main(int argc, char* argv[])
+{
+  bool success = true;
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) success &= benchmark(argv[i]) && benchmark_packed(argv[i]);
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  for (size_t i = 0; i < sizeof(default_models) / sizeof(default_models[0]); i++) {
+    success &= benchmark(default_models[i]) && benchmark_packed(default_models[i]);
+  }
+
+  for (size_t i = 0; i < sizeof(default_grid_sizes) / sizeof(default_grid_sizes[0]); i++) {
+    char path[64];
+    snprintf(path, sizeof(path), "mesh_load_benchmark_grid%zu.obj", default_grid_sizes[i]);
+
+    if (!write_grid(path, default_grid_sizes[i])) {
+      success = false;
+      continue;
+    }
+
+    success &= benchmark(path) && benchmark_packed(path);
+    remove_cache(path);
+    remove(path);
+  }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static double get_time(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Writes a flat `size` x `size` quad grid with a uv and a shared normal per face element.
+static bool write_grid(const char* path, size_t size)
+{
+  FILE* file = fopen(path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to create grid file: %s\n", path);
+    return false;
+  }
+
+  for (size_t y = 0; y <= size; y++) {
+    for (size_t x = 0; x <= size; x++) fprintf(file, "v %zu 0 %zu\n", x, y);
+  }
+  for (size_t y = 0; y <= size; y++) {
+    for (size_t x = 0; x <= size; x++) fprintf(file, "vt %g %g\n", (double)x / size, (double)y / size);
+  }
+  fprintf(file, "vn 0 1 0\n");
+
+  for (size_t y = 0; y < size; y++) {
+    for (size_t x = 0; x < size; x++) {
+      const size_t i0 = y * (size + 1) + x + 1;
+      const size_t i1 = i0 + 1;
+      const size_t i2 = i0 + size + 1;
+      const size_t i3 = i2 + 1;
+      fprintf(file, "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", i0, i0, i2, i2, i1, i1);
+      fprintf(file, "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", i1, i1, i2, i2, i3, i3);
+    }
+  }
+
+  const bool success = ferror(file) == 0;
+  if (fclose(file) != 0 || !success) {
+    fprintf(stderr, "Failed to write grid file: %s\n", path);
+    return false;
+  }
+
+  return true;
+}
+
+static void remove_cache(const char* path)
+{
+  char* cache_path = mesh_cache_path(path, "Normal");
+  if (cache_path != NULL) {
+    remove(cache_path);
+    free(cache_path);
+  }
+}
+
+static bool time_load(const char* path,
+                      bool cold,
+                      double* seconds,
+                      size_t* num_triangles,
+                      MeshOptimizationStats* optimization)
+{
+  if (cold) remove_cache(path);
+
+  NormalMesh mesh = normal_mesh_make();
+  const double start = get_time();
+  const bool success = normal_mesh_load_from_file(&mesh, path, false, false);
+  *seconds = get_time() - start;
+
+  *num_triangles = mesh.indices.size / 3;
+  *optimization = mesh.optimization;
+  normal_mesh_destroy(&mesh);
+  return success;
+}
+
+static bool benchmark(const char* path)
+{
+  double best_cold = 0.0;
+  double best_cached = 0.0;
+  size_t num_triangles = 0;
+  MeshOptimizationStats optimization;
+
+  for (int run = 0; run < NUM_RUNS; run++) {
+    double cold, cached;
+    if (!time_load(path, true, &cold, &num_triangles, &optimization) ||
+        !time_load(path, false, &cached, &num_triangles, &optimization)) {
+      fprintf(stderr, "Failed to load mesh: %s\n", path);
+      return false;
+    }
+
+    if (run == 0 || cold < best_cold) best_cold = cold;
+    if (run == 0 || cached < best_cached) best_cached = cached;
+  }
+
+  printf("%-40s %9zu tris  cold %9.2f ms  cached %7.2f ms  misses %.3f -> %.3f\n",
+         path,
+         num_triangles,
+         best_cold * 1000.0,
+         best_cached * 1000.0,
+         optimization.misses_before,
+         optimization.misses_after);
+  return true;
+}
+
+static bool benchmark_packed(const char* path)
+{
+  NormalMesh mesh = normal_mesh_make();
+  if (!normal_mesh_load_from_file(&mesh, path, false, false)) {
+    fprintf(stderr, "Failed to load mesh: %s\n", path);
+    normal_mesh_destroy(&mesh);
+    return false;
+  }
+  normal_mesh_interpolate_normals(&mesh, NULL);
+  PackedMesh packed_mesh = normal_mesh_pack(&mesh);
+
+  Graphics graphics = graphics_make(SCREEN_WIDTH, SCREEN_HEIGHT);
+  DepthBuffer* depth_buffer = depth_buffer_make(SCREEN_WIDTH, SCREEN_HEIGHT);
+  PhongPipeline pipeline = phong_pipeline_make(&graphics, depth_buffer);
+  PackedPhongPipeline packed_pipeline = packed_phong_pipeline_make(&graphics, depth_buffer);
+
+  // Centers the mesh in front of the camera, tilted towards it so that flat grids aren't seen edge on.
+  const float radius = mesh.bounds_radius;
+  const Mat4 projection =
+    mat4_projection(90.0f, (float)SCREEN_WIDTH / SCREEN_HEIGHT, 0.01f * radius, 10.0f * radius);
+  const Mat4 translation = mat4_translation(0.0f, 0.0f, -1.5f * radius);
+  const Mat4 rotation = mat4_rotation_x(0.5f);
+  const Mat4 centering = mat4_translation(-mesh.bounds_center.x, -mesh.bounds_center.y, -mesh.bounds_center.z);
+  Mat4 world = mat4_mul(&translation, &rotation);
+  world = mat4_mul(&world, &centering);
+
+  phong_effect_set_projection(&pipeline.effect, &projection);
+  phong_effect_set_world(&pipeline.effect, &world);
+  phong_effect_set_projection(&packed_pipeline.effect, &projection);
+  phong_effect_set_dequantize(&packed_pipeline.effect, &packed_mesh.quantization.dequantize);
+  phong_effect_set_world(&packed_pipeline.effect, &world);
+
+  double best_draw = 0.0;
+  double best_packed_draw = 0.0;
+  PipelineStats stats = { 0 };
+
+  for (int run = 0; run < NUM_DRAWS; run++) {
+    depth_buffer_clear(depth_buffer);
+    double start = get_time();
+    phong_pipeline_draw(&pipeline, &mesh, &stats);
+    const double draw = get_time() - start;
+
+    depth_buffer_clear(depth_buffer);
+    start = get_time();
+    packed_phong_pipeline_draw(&packed_pipeline, &packed_mesh, &stats);
+    const double packed_draw = get_time() - start;
+
+    if (run == 0 || draw < best_draw) best_draw = draw;
+    if (run == 0 || packed_draw < best_packed_draw) best_packed_draw = packed_draw;
+  }
+
+  printf("%-40s packed vertices %8.1f -> %8.1f KiB  draw %7.2f -> %7.2f ms\n",
+         path,
+         mesh.vertices.size * mesh.vertices.type_size / 1024.0,
+         packed_mesh.vertices.size * packed_mesh.vertices.type_size / 1024.0,
+         best_draw * 1000.0,
+         best_packed_draw * 1000.0);
+
+  depth_buffer_destroy(depth_buffer);
+  graphics_destroy(&graphics);
+  packed_mesh_destroy(&packed_mesh);
+  normal_mesh_destroy(&mesh);
+  return true;
+}
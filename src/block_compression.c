@@ -0,0 +1,274 @@
+#include "block_compression.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+static void encode_color_block(const Color texels[BLOCK_NUM_TEXELS], unsigned char block[8], bool allow_transparency);
+static void decode_color_block(const unsigned char block[8], Color texels[BLOCK_NUM_TEXELS], bool allow_transparency);
+static void color_block_palette(uint16_t c0, uint16_t c1, bool four_color, Color palette[4]);
+static void encode_alpha_block(const Color texels[BLOCK_NUM_TEXELS], unsigned char block[8]);
+static void decode_alpha_block(const unsigned char block[8], unsigned char alphas[BLOCK_NUM_TEXELS]);
+static void alpha_block_palette(unsigned char a0, unsigned char a1, unsigned char palette[8]);
+
+static uint16_t rgb_to_565(int r, int g, int b);
+static Color rgb565_to_color(uint16_t c);
+static Color color_make(int r, int g, int b, int a);
+static int color_distance_squared(Color c, Color d);
+
+static inline int color_red(Color c)
+{
+  return (c >> 24) & 0xff;
+}
+
+static inline int color_green(Color c)
+{
+  return (c >> 16) & 0xff;
+}
+
+static inline int color_blue(Color c)
+{
+  return (c >> 8) & 0xff;
+}
+
+static inline int color_alpha(Color c)
+{
+  return c & 0xff;
+}
+
+void bc1_encode_block(const Color texels[BLOCK_NUM_TEXELS], unsigned char block[BC1_BLOCK_SIZE])
+{
+  encode_color_block(texels, block, true);
+}
+
+void bc1_decode_block(const unsigned char block[BC1_BLOCK_SIZE], Color texels[BLOCK_NUM_TEXELS])
+{
+  decode_color_block(block, texels, true);
+}
+
+void bc3_encode_block(const Color texels[BLOCK_NUM_TEXELS], unsigned char block[BC3_BLOCK_SIZE])
+{
+  encode_alpha_block(texels, &block[0]);
+  encode_color_block(texels, &block[8], false);
+}
+
+void bc3_decode_block(const unsigned char block[BC3_BLOCK_SIZE], Color texels[BLOCK_NUM_TEXELS])
+{
+  unsigned char alphas[BLOCK_NUM_TEXELS];
+  decode_alpha_block(&block[0], alphas);
+  decode_color_block(&block[8], texels, false);
+
+  for (int i = 0; i < BLOCK_NUM_TEXELS; i++) {
+    texels[i] = (texels[i] & 0xffffff00) | alphas[i];
+  }
+}
+
+// Endpoints are the (slightly inset) corners of the RGB bounding box of the block. When `allow_transparency` is set
+// and the block contains texels with alpha below one half, the block is encoded in three-color mode with index 3
+// meaning transparent black, as BC1 specifies.
+static void encode_color_block(const Color texels[BLOCK_NUM_TEXELS], unsigned char block[8], bool allow_transparency)
+{
+  int min[3] = { 255, 255, 255 };
+  int max[3] = { 0, 0, 0 };
+  bool transparent[BLOCK_NUM_TEXELS];
+  bool any_transparent = false;
+  bool any_opaque = false;
+
+  for (int i = 0; i < BLOCK_NUM_TEXELS; i++) {
+    transparent[i] = allow_transparency && color_alpha(texels[i]) < 128;
+    if (transparent[i]) {
+      any_transparent = true;
+      continue;
+    }
+    any_opaque = true;
+
+    const int channels[3] = { color_red(texels[i]), color_green(texels[i]), color_blue(texels[i]) };
+    for (int c = 0; c < 3; c++) {
+      if (channels[c] < min[c]) min[c] = channels[c];
+      if (channels[c] > max[c]) max[c] = channels[c];
+    }
+  }
+
+  if (!any_opaque) {
+    min[0] = min[1] = min[2] = max[0] = max[1] = max[2] = 0;
+  }
+
+  // Pull the endpoints in a little so that the interpolated colors land closer to the actual texels.
+  for (int c = 0; c < 3; c++) {
+    const int inset = (max[c] - min[c]) / 16;
+    min[c] += inset;
+    max[c] -= inset;
+  }
+
+  uint16_t c0 = rgb_to_565(max[0], max[1], max[2]);
+  uint16_t c1 = rgb_to_565(min[0], min[1], min[2]);
+
+  // Four-color mode is signalled by c0 > c1, three-color mode by c0 <= c1.
+  const bool four_color = !any_transparent;
+  if ((four_color && c0 < c1) || (!four_color && c0 > c1)) {
+    const uint16_t temp = c0;
+    c0 = c1;
+    c1 = temp;
+  }
+
+  Color palette[4];
+  color_block_palette(c0, c1, four_color || !allow_transparency, palette);
+  const int num_candidates = (four_color && c0 != c1) ? 4 : 3;
+
+  uint32_t indices = 0;
+  for (int i = 0; i < BLOCK_NUM_TEXELS; i++) {
+    int best_index = 3;
+    if (!transparent[i]) {
+      int best_distance = color_distance_squared(texels[i], palette[0]);
+      best_index = 0;
+      for (int j = 1; j < num_candidates; j++) {
+        const int distance = color_distance_squared(texels[i], palette[j]);
+        if (distance < best_distance) {
+          best_distance = distance;
+          best_index = j;
+        }
+      }
+    }
+    indices |= (uint32_t)best_index << (2 * i);
+  }
+
+  block[0] = c0 & 0xff;
+  block[1] = c0 >> 8;
+  block[2] = c1 & 0xff;
+  block[3] = c1 >> 8;
+  block[4] = indices & 0xff;
+  block[5] = (indices >> 8) & 0xff;
+  block[6] = (indices >> 16) & 0xff;
+  block[7] = indices >> 24;
+}
+
+// BC3 color blocks are always decoded in four-color mode, regardless of endpoint order.
+static void decode_color_block(const unsigned char block[8], Color texels[BLOCK_NUM_TEXELS], bool allow_transparency)
+{
+  const uint16_t c0 = block[0] | (block[1] << 8);
+  const uint16_t c1 = block[2] | (block[3] << 8);
+  const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+
+  Color palette[4];
+  color_block_palette(c0, c1, !allow_transparency || c0 > c1, palette);
+
+  for (int i = 0; i < BLOCK_NUM_TEXELS; i++) {
+    texels[i] = palette[(indices >> (2 * i)) & 3];
+  }
+}
+
+static void color_block_palette(uint16_t c0, uint16_t c1, bool four_color, Color palette[4])
+{
+  palette[0] = rgb565_to_color(c0);
+  palette[1] = rgb565_to_color(c1);
+
+  const int r0 = color_red(palette[0]);
+  const int g0 = color_green(palette[0]);
+  const int b0 = color_blue(palette[0]);
+  const int r1 = color_red(palette[1]);
+  const int g1 = color_green(palette[1]);
+  const int b1 = color_blue(palette[1]);
+
+  if (four_color) {
+    palette[2] = color_make((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, 255);
+    palette[3] = color_make((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, 255);
+  } else {
+    palette[2] = color_make((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
+    palette[3] = color_make(0, 0, 0, 0);
+  }
+}
+
+static void encode_alpha_block(const Color texels[BLOCK_NUM_TEXELS], unsigned char block[8])
+{
+  unsigned char a0 = 0;
+  unsigned char a1 = 255;
+  for (int i = 0; i < BLOCK_NUM_TEXELS; i++) {
+    const unsigned char alpha = color_alpha(texels[i]);
+    if (alpha > a0) a0 = alpha;
+    if (alpha < a1) a1 = alpha;
+  }
+
+  unsigned char palette[8];
+  alpha_block_palette(a0, a1, palette);
+
+  uint64_t indices = 0;
+  if (a0 != a1) {
+    for (int i = 0; i < BLOCK_NUM_TEXELS; i++) {
+      const int alpha = color_alpha(texels[i]);
+      int best_index = 0;
+      int best_distance = 256;
+      for (int j = 0; j < 8; j++) {
+        const int distance = alpha > palette[j] ? alpha - palette[j] : palette[j] - alpha;
+        if (distance < best_distance) {
+          best_distance = distance;
+          best_index = j;
+        }
+      }
+      indices |= (uint64_t)best_index << (3 * i);
+    }
+  }
+
+  block[0] = a0;
+  block[1] = a1;
+  for (int i = 0; i < 6; i++) {
+    block[2 + i] = (indices >> (8 * i)) & 0xff;
+  }
+}
+
+static void decode_alpha_block(const unsigned char block[8], unsigned char alphas[BLOCK_NUM_TEXELS])
+{
+  unsigned char palette[8];
+  alpha_block_palette(block[0], block[1], palette);
+
+  uint64_t indices = 0;
+  for (int i = 0; i < 6; i++) {
+    indices |= (uint64_t)block[2 + i] << (8 * i);
+  }
+
+  for (int i = 0; i < BLOCK_NUM_TEXELS; i++) {
+    alphas[i] = palette[(indices >> (3 * i)) & 7];
+  }
+}
+
+static void alpha_block_palette(unsigned char a0, unsigned char a1, unsigned char palette[8])
+{
+  palette[0] = a0;
+  palette[1] = a1;
+
+  if (a0 > a1) {
+    for (int i = 2; i < 8; i++) {
+      palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    }
+  } else {
+    for (int i = 2; i < 6; i++) {
+      palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+    }
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+static uint16_t rgb_to_565(int r, int g, int b)
+{
+  return ((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255);
+}
+
+static Color rgb565_to_color(uint16_t c)
+{
+  const int r = (c >> 11) & 31;
+  const int g = (c >> 5) & 63;
+  const int b = c & 31;
+  return color_make((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255);
+}
+
+static Color color_make(int r, int g, int b, int a)
+{
+  return ((Color)r << 24) | ((Color)g << 16) | ((Color)b << 8) | (Color)a;
+}
+
+static int color_distance_squared(Color c, Color d)
+{
+  const int dr = color_red(c) - color_red(d);
+  const int dg = color_green(c) - color_green(d);
+  const int db = color_blue(c) - color_blue(d);
+  return dr * dr + dg * dg + db * db;
+}
@@ -0,0 +1,18 @@
+#ifndef BLOCK_COMPRESSION_H_
+#define BLOCK_COMPRESSION_H_
+
+#include "graphics.h"
+
+// BC1 (DXT1) and BC3 (DXT5) compression of 4x4 texel blocks. Texels are given and returned in row-major order.
+
+#define BLOCK_DIMENSION  4
+#define BLOCK_NUM_TEXELS (BLOCK_DIMENSION * BLOCK_DIMENSION)
+#define BC1_BLOCK_SIZE   8
+#define BC3_BLOCK_SIZE   16
+
+void bc1_encode_block(const Color texels[BLOCK_NUM_TEXELS], unsigned char block[BC1_BLOCK_SIZE]);
+void bc1_decode_block(const unsigned char block[BC1_BLOCK_SIZE], Color texels[BLOCK_NUM_TEXELS]);
+void bc3_encode_block(const Color texels[BLOCK_NUM_TEXELS], unsigned char block[BC3_BLOCK_SIZE]);
+void bc3_decode_block(const unsigned char block[BC3_BLOCK_SIZE], Color texels[BLOCK_NUM_TEXELS]);
+
+#endif
@@ -0,0 +1,259 @@
+#include "bvh.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <tgmath.h>
+
+#define NO_PARENT      UINT32_MAX
+#define MAX_CULL_DEPTH 64
+#define ALL_PLANES     0x3f
+
+static void bvh_build_node(Bvh* bvh, uint32_t node_index, uint32_t begin, uint32_t end, const Vec3 centroids[]);
+static void bvh_select(uint32_t order[], uint32_t begin, uint32_t end, uint32_t nth, const Vec3 centroids[], int axis);
+static bool bvh_node_fit(Bvh* bvh, uint32_t node_index);
+static bool bvh_box_outside(const Frustum* frustum, const Vec3* min, const Vec3* max, uint32_t* planes);
+static float vec3_component(const Vec3* v, int axis);
+
+Bvh bvh_make(void)
+{
+  return (Bvh){
+    .nodes = dyn_list_make(sizeof(BvhNode)),
+    .order = dyn_list_make(sizeof(uint32_t)),
+    .object_nodes = dyn_list_make(sizeof(uint32_t)),
+    .bounds = dyn_list_make(sizeof(Vec3)),
+  };
+}
+
+void bvh_destroy(Bvh* bvh)
+{
+  dyn_list_destroy(&bvh->nodes);
+  dyn_list_destroy(&bvh->order);
+  dyn_list_destroy(&bvh->object_nodes);
+  dyn_list_destroy(&bvh->bounds);
+}
+
+// Replaces the tree with one over the given boxes. Nodes are split at the median of their objects' centers, along the
+// axis on which those are spread out the most, which keeps the tree balanced.
+void bvh_build(Bvh* bvh, const Vec3 bounds_min[], const Vec3 bounds_max[], size_t num_objects)
+{
+  assert(num_objects < UINT32_MAX);
+
+  bvh->nodes.size = 0;
+  bvh->order.size = 0;
+  bvh->object_nodes.size = 0;
+  bvh->bounds.size = 0;
+  if (num_objects == 0) return;
+
+  dyn_list_reserve(&bvh->order, num_objects);
+  dyn_list_reserve(&bvh->object_nodes, num_objects);
+  dyn_list_reserve(&bvh->bounds, 2 * num_objects);
+
+  Vec3* centroids = malloc(num_objects * sizeof(Vec3));
+  for (uint32_t i = 0; i < num_objects; i++) {
+    const uint32_t no_node = 0;
+    dyn_list_add(&bvh->order, &i);
+    dyn_list_add(&bvh->object_nodes, &no_node);
+    dyn_list_add(&bvh->bounds, &bounds_min[i]);
+    dyn_list_add(&bvh->bounds, &bounds_max[i]);
+    centroids[i] = vec3_make((bounds_min[i].x + bounds_max[i].x) / 2.0f,
+                             (bounds_min[i].y + bounds_max[i].y) / 2.0f,
+                             (bounds_min[i].z + bounds_max[i].z) / 2.0f);
+  }
+
+  const BvhNode root = { .parent = NO_PARENT };
+  dyn_list_add(&bvh->nodes, &root);
+  bvh_build_node(bvh, 0, 0, num_objects, centroids);
+
+  free(centroids);
+}
+
+// Moves an object's box and refits the nodes above it, which is cheap but makes the tree looser the further objects
+// move from where they were when it was built.
+void bvh_refit(Bvh* bvh, size_t object, const Vec3* bounds_min, const Vec3* bounds_max)
+{
+  Vec3* bounds = dyn_list_mutable_at(&bvh->bounds, 2 * object);
+  bounds[0] = *bounds_min;
+  bounds[1] = *bounds_max;
+
+  // Nodes further up can only change if the one below them did.
+  uint32_t node_index = *(const uint32_t*)dyn_list_at(&bvh->object_nodes, object);
+  while (node_index != NO_PARENT && bvh_node_fit(bvh, node_index)) {
+    node_index = ((const BvhNode*)dyn_list_at(&bvh->nodes, node_index))->parent;
+  }
+}
+
+// Adds the index of every object whose box is at least partly inside the frustum to `visible` (size_t). Planes that a
+// node is entirely inside of aren't tested again below it, so nodes entirely inside the frustum cost no tests at all.
+void bvh_cull(const Bvh* bvh, const Frustum* frustum, DynList* visible)
+{
+  if (bvh->nodes.size == 0) return;
+
+  const BvhNode* nodes = (const BvhNode*)bvh->nodes.buffer;
+  const uint32_t* order = (const uint32_t*)bvh->order.buffer;
+  const Vec3* bounds = (const Vec3*)bvh->bounds.buffer;
+
+  struct
+  {
+    uint32_t node;
+    uint32_t planes;  // Bit i is set if the node may cross plane i
+  } stack[MAX_CULL_DEPTH];
+  size_t stack_size = 1;
+  stack[0].node = 0;
+  stack[0].planes = ALL_PLANES;
+
+  while (stack_size > 0) {
+    stack_size--;
+    const BvhNode* node = &nodes[stack[stack_size].node];
+    uint32_t planes = stack[stack_size].planes;
+    if (bvh_box_outside(frustum, &node->min, &node->max, &planes)) continue;
+
+    if (node->count > 0) {
+      for (uint32_t i = node->first; i < node->first + node->count; i++) {
+        uint32_t object_planes = planes;
+        if (bvh_box_outside(frustum, &bounds[2 * order[i]], &bounds[2 * order[i] + 1], &object_planes)) continue;
+
+        const size_t object = order[i];
+        dyn_list_add(visible, &object);
+      }
+    } else {
+      assert(stack_size + 2 <= MAX_CULL_DEPTH);
+      stack[stack_size].node = node->first + 1;
+      stack[stack_size].planes = planes;
+      stack[stack_size + 1].node = node->first;
+      stack[stack_size + 1].planes = planes;
+      stack_size += 2;
+    }
+  }
+}
+
+static void bvh_build_node(Bvh* bvh, uint32_t node_index, uint32_t begin, uint32_t end, const Vec3 centroids[])
+{
+  uint32_t* order = (uint32_t*)bvh->order.buffer;
+
+  if (end - begin <= BVH_MAX_LEAF_OBJECTS) {
+    BvhNode* node = dyn_list_mutable_at(&bvh->nodes, node_index);
+    node->first = begin;
+    node->count = end - begin;
+    for (uint32_t i = begin; i < end; i++) {
+      *(uint32_t*)dyn_list_mutable_at(&bvh->object_nodes, order[i]) = node_index;
+    }
+    bvh_node_fit(bvh, node_index);
+    return;
+  }
+
+  Vec3 centroids_min = centroids[order[begin]];
+  Vec3 centroids_max = centroids_min;
+  for (uint32_t i = begin + 1; i < end; i++) {
+    const Vec3* c = &centroids[order[i]];
+    centroids_min = vec3_make(fmin(centroids_min.x, c->x), fmin(centroids_min.y, c->y), fmin(centroids_min.z, c->z));
+    centroids_max = vec3_make(fmax(centroids_max.x, c->x), fmax(centroids_max.y, c->y), fmax(centroids_max.z, c->z));
+  }
+  const Vec3 extent = vec3_sub(&centroids_max, &centroids_min);
+  const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+
+  const uint32_t middle = begin + (end - begin) / 2;
+  bvh_select(order, begin, end, middle, centroids, axis);
+
+  const uint32_t first_child = bvh->nodes.size;
+  const BvhNode child = { .parent = node_index };
+  dyn_list_add(&bvh->nodes, &child);
+  dyn_list_add(&bvh->nodes, &child);
+  BvhNode* node = dyn_list_mutable_at(&bvh->nodes, node_index);
+  node->first = first_child;
+  node->count = 0;
+
+  bvh_build_node(bvh, first_child, begin, middle, centroids);
+  bvh_build_node(bvh, first_child + 1, middle, end, centroids);
+  bvh_node_fit(bvh, node_index);
+}
+
+// Reorders `order[begin..end)` so that the object at `nth` is the one that would be there if they were sorted along
+// `axis`, with no object before it further along and none after it less far (Hoare's quickselect).
+static void bvh_select(uint32_t order[], uint32_t begin, uint32_t end, uint32_t nth, const Vec3 centroids[], int axis)
+{
+  while (end - begin > 1) {
+    const float pivot = vec3_component(&centroids[order[begin + (end - begin) / 2]], axis);
+    uint32_t i = begin;
+    uint32_t j = end - 1;
+    while (i <= j) {
+      while (vec3_component(&centroids[order[i]], axis) < pivot) i++;
+      while (vec3_component(&centroids[order[j]], axis) > pivot) j--;
+      if (i <= j) {
+        const uint32_t temp = order[i];
+        order[i] = order[j];
+        order[j] = temp;
+        i++;
+        if (j == 0) break;
+        j--;
+      }
+    }
+
+    // Everything in [begin, j] is at most the pivot, and everything in [i, end) at least.
+    if (nth <= j) {
+      end = j + 1;
+    } else if (nth >= i) {
+      begin = i;
+    } else {
+      return;
+    }
+  }
+}
+
+// Fits the node's box around its objects or children. Returns true if the box changed.
+static bool bvh_node_fit(Bvh* bvh, uint32_t node_index)
+{
+  BvhNode* node = dyn_list_mutable_at(&bvh->nodes, node_index);
+  Vec3 min;
+  Vec3 max;
+
+  if (node->count > 0) {
+    const uint32_t* order = (const uint32_t*)bvh->order.buffer;
+    const Vec3* bounds = (const Vec3*)bvh->bounds.buffer;
+    min = bounds[2 * order[node->first]];
+    max = bounds[2 * order[node->first] + 1];
+    for (uint32_t i = node->first + 1; i < node->first + node->count; i++) {
+      const Vec3* object_min = &bounds[2 * order[i]];
+      const Vec3* object_max = &bounds[2 * order[i] + 1];
+      min = vec3_make(fmin(min.x, object_min->x), fmin(min.y, object_min->y), fmin(min.z, object_min->z));
+      max = vec3_make(fmax(max.x, object_max->x), fmax(max.y, object_max->y), fmax(max.z, object_max->z));
+    }
+  } else {
+    const BvhNode* left = dyn_list_at(&bvh->nodes, node->first);
+    const BvhNode* right = dyn_list_at(&bvh->nodes, node->first + 1);
+    min = vec3_make(fmin(left->min.x, right->min.x), fmin(left->min.y, right->min.y), fmin(left->min.z, right->min.z));
+    max = vec3_make(fmax(left->max.x, right->max.x), fmax(left->max.y, right->max.y), fmax(left->max.z, right->max.z));
+  }
+
+  const bool changed = min.x != node->min.x || min.y != node->min.y || min.z != node->min.z ||
+                       max.x != node->max.x || max.y != node->max.y || max.z != node->max.z;
+  node->min = min;
+  node->max = max;
+  return changed;
+}
+
+// Tests the box against the planes whose bits are set, and clears the bits of those that it's entirely inside of.
+static bool bvh_box_outside(const Frustum* frustum, const Vec3* min, const Vec3* max, uint32_t* planes)
+{
+  for (int i = 0; i < 6; i++) {
+    if (!(*planes & (1u << i))) continue;
+
+    // The corners furthest and nearest along the plane's normal.
+    const Vec4* plane = &frustum->planes[i];
+    const Vec3 far = vec3_make(plane->x >= 0.0f ? max->x : min->x,
+                               plane->y >= 0.0f ? max->y : min->y,
+                               plane->z >= 0.0f ? max->z : min->z);
+    if (plane->x * far.x + plane->y * far.y + plane->z * far.z + plane->w < 0.0f) return true;
+
+    const Vec3 near = vec3_make(plane->x >= 0.0f ? min->x : max->x,
+                                plane->y >= 0.0f ? min->y : max->y,
+                                plane->z >= 0.0f ? min->z : max->z);
+    if (plane->x * near.x + plane->y * near.y + plane->z * near.z + plane->w >= 0.0f) *planes &= ~(1u << i);
+  }
+  return false;
+}
+
+static float vec3_component(const Vec3* v, int axis)
+{
+  return axis == 0 ? v->x : axis == 1 ? v->y : v->z;
+}
@@ -0,0 +1,39 @@
+#ifndef BVH_H_
+#define BVH_H_
+
+#include "dynlist.h"
+#include "frustum.h"
+#include "vector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BVH_MAX_LEAF_OBJECTS 4
+
+// An inner node's children are next to each other, starting at `first`. A leaf's objects are `count` consecutive
+// entries of the tree's object order, starting at `first`.
+typedef struct
+{
+  Vec3 min;
+  Vec3 max;
+  uint32_t first;
+  uint32_t count;   // Zero for inner nodes
+  uint32_t parent;  // UINT32_MAX for the root
+} BvhNode;
+
+// A bounding volume hierarchy over a set of axis aligned boxes, which are referred to by their index.
+typedef struct
+{
+  DynList nodes;         // BvhNode, the root first
+  DynList order;         // uint32_t, the objects in leaf order
+  DynList object_nodes;  // uint32_t, the leaf of each object
+  DynList bounds;        // Vec3, the minimum and maximum of each object
+} Bvh;
+
+Bvh bvh_make(void);
+void bvh_destroy(Bvh* bvh);
+void bvh_build(Bvh* bvh, const Vec3 bounds_min[], const Vec3 bounds_max[], size_t num_objects);
+void bvh_refit(Bvh* bvh, size_t object, const Vec3* bounds_min, const Vec3* bounds_max);
+void bvh_cull(const Bvh* bvh, const Frustum* frustum, DynList* visible);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef CULL_MODE_H_
+#define CULL_MODE_H_
+
+// Which triangles a pipeline skips. Front faces are wound counter clockwise as seen from the camera, as in OBJ files.
+typedef enum {
+  CULL_BACK,
+  CULL_FRONT,
+  CULL_NONE,
+} CullMode;
+
+#endif
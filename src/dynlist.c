@@ -1,6 +1,7 @@
 #include "dynlist.h"
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <assert.h>
 
@@ -15,29 +16,48 @@ DynList dyn_list_make(size_t type_size)
   };
 }
 
+// The list borrows `buffer`, which has to outlive it. The first time the list grows, its contents are copied into a
+// buffer of its own.
+DynList dyn_list_make_view(void* buffer, size_t size, size_t type_size)
+{
+  return (DynList){
+    .buffer = buffer,
+    .size = size,
+    .capacity = 0,
+    .type_size = type_size,
+  };
+}
+
+// The copy always owns its buffer, even if `list` is a view.
+DynList dyn_list_copy(const DynList* list)
+{
+  DynList copy = dyn_list_make(list->type_size);
+  dyn_list_append(&copy, list->buffer, list->size);
+  return copy;
+}
+
 void dyn_list_destroy(DynList* list)
 {
-  free(list->buffer);
+  if (list->capacity > 0) free(list->buffer);
   list->buffer = NULL;
   list->size = 0;
   list->capacity = 0;
   list->type_size = 0;
 }
 
+// Returns NULL, and leaves the list as it was, if the list can't grow.
 void* dyn_list_add(DynList* list, const void* data_ptr)
 {
   void* dest = dyn_list_add_slot(list);
-  memcpy(dest, data_ptr, list->type_size);
+  if (dest != NULL) memcpy(dest, data_ptr, list->type_size);
   return dest;
 }
 
+// Returns NULL, and leaves the list as it was, if the list can't grow.
 void* dyn_list_add_slot(DynList* list)
 {
-  if (list->size >= list->capacity) {
-    const size_t new_capacity = 2 * list->capacity;
-    const size_t num_bytes = new_capacity * list->type_size;
-    list->buffer = realloc(list->buffer, num_bytes);
-    list->capacity = new_capacity;
+  if (list->size >= list->capacity && !dyn_list_reserve(list, list->size + 1)) {
+    return NULL;
   }
 
   const size_t offset = list->size * list->type_size;
@@ -47,6 +67,47 @@ void* dyn_list_add_slot(DynList* list)
   return dest;
 }
 
+// Returns false, and leaves the list as it was, if the list can't grow.
+bool dyn_list_append(DynList* list, const void* data, size_t count)
+{
+  if (count > SIZE_MAX - list->size || !dyn_list_reserve(list, list->size + count)) return false;
+  memcpy(list->buffer + list->size * list->type_size, data, count * list->type_size);
+  list->size += count;
+  return true;
+}
+
+// Returns false, and leaves the list as it was, if the memory can't be allocated.
+bool dyn_list_reserve(DynList* list, size_t capacity)
+{
+  if (capacity <= list->capacity) return true;
+  if (capacity > SIZE_MAX / 2 / list->type_size) return false;
+
+  size_t new_capacity = list->capacity > 0 ? list->capacity : 1;
+  while (new_capacity < capacity) new_capacity *= 2;
+
+  unsigned char* buffer;
+  if (list->capacity > 0) {
+    buffer = realloc(list->buffer, new_capacity * list->type_size);
+    if (buffer == NULL) return false;
+  } else {
+    buffer = malloc(new_capacity * list->type_size);
+    if (buffer == NULL) return false;
+    if (list->size > 0) memcpy(buffer, list->buffer, list->size * list->type_size);
+  }
+  list->buffer = buffer;
+  list->capacity = new_capacity;
+  return true;
+}
+
+// Gives back the unused capacity. Views are left alone.
+void dyn_list_shrink_to_fit(DynList* list)
+{
+  if (list->capacity == 0 || list->size == 0 || list->size == list->capacity) return;
+
+  list->buffer = realloc(list->buffer, list->size * list->type_size);
+  list->capacity = list->size;
+}
+
 void* dyn_list_mutable_at(DynList* list, size_t index)
 {
   assert(index < list->size);
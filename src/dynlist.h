@@ -8,14 +8,19 @@ typedef struct
 {
   unsigned char* buffer;
   size_t size;
-  size_t capacity;
+  size_t capacity;   // Zero if the buffer is borrowed
   size_t type_size;  // Size of element type in bytes
 } DynList;
 
 DynList dyn_list_make(size_t type_size);
+DynList dyn_list_make_view(void* buffer, size_t size, size_t type_size);
+DynList dyn_list_copy(const DynList* list);
 void dyn_list_destroy(DynList* list);
 void* dyn_list_add(DynList* list, const void* data_ptr);
 void* dyn_list_add_slot(DynList* list);
+bool dyn_list_append(DynList* list, const void* data, size_t count);
+bool dyn_list_reserve(DynList* list, size_t capacity);
+void dyn_list_shrink_to_fit(DynList* list);
 void* dyn_list_mutable_at(DynList* list, size_t index);
 const void* dyn_list_at(const DynList* list, size_t index);
 bool dyn_list_search(const DynList* list, const void* value, size_t* index, bool equal(const void*, const void*));
@@ -63,6 +63,16 @@ void default_effect_vertex_shader(const DefaultEffect* effect, const DefaultEffe
   out->pos = mat4_vec_mul(&effect->proj_world, &in_pos);
 }
 
+// Shades all of `streams` at once.
+void default_effect_streams_vertex_shader(const DefaultEffect* effect,
+                                          const VertexStreams* streams,
+                                          DefaultEffectVSOut out[])
+{
+  const size_t stride = sizeof(DefaultEffectVSOut);
+  mat4_transform_streams(
+    &effect->proj_world, streams->x, streams->y, streams->z, 1.0f, streams->num_vertices, &out->pos, stride);
+}
+
 void default_effect_geometry_shader(const DefaultEffect* effect,
                                     const DefaultEffectVSOut* in0,
                                     const DefaultEffectVSOut* in1,
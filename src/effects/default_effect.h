@@ -4,6 +4,7 @@
 #include "vector.h"
 #include "matrix.h"
 #include "graphics.h"
+#include "vertex_streams.h"
 #include "meshes/position_mesh.h"
 
 #include <stddef.h>
@@ -42,6 +43,9 @@ void default_effect_set_world(DefaultEffect* effect, const Mat4* world);
 void default_effect_set_projection(DefaultEffect* effect, const Mat4* projection);
 
 void default_effect_vertex_shader(const DefaultEffect* effect, const DefaultEffectVertex* in, DefaultEffectVSOut* out);
+void default_effect_streams_vertex_shader(const DefaultEffect* effect,
+                                          const VertexStreams* streams,
+                                          DefaultEffectVSOut out[]);
 void default_effect_geometry_shader(const DefaultEffect* effect,
                                     const DefaultEffectVSOut* in0,
                                     const DefaultEffectVSOut* in1,
@@ -2,6 +2,8 @@
 
 #include <tgmath.h>
 
+static void phong_effect_update_transforms(PhongEffect* effect);
+
 PhongEffectGSOut phong_effect_gsout_add(const PhongEffectGSOut* v, const PhongEffectGSOut* w)
 {
   return (PhongEffectGSOut){
@@ -51,19 +53,27 @@ PhongEffect phong_effect_make(const Graphics* graphics)
 {
   return (PhongEffect){
     .graphics = graphics,
+    .dequantize = mat4_identity(),
   };
 }
 
 void phong_effect_set_world(PhongEffect* effect, const Mat4* world)
 {
   effect->world = *world;
-  effect->proj_world = mat4_mul(&effect->projection, &effect->world);
+  phong_effect_update_transforms(effect);
 }
 
 void phong_effect_set_projection(PhongEffect* effect, const Mat4* projection)
 {
   effect->projection = *projection;
-  effect->proj_world = mat4_mul(&effect->projection, &effect->world);
+  phong_effect_update_transforms(effect);
+}
+
+// Only needed for packed vertices, see `PositionQuantization`.
+void phong_effect_set_dequantize(PhongEffect* effect, const Mat4* dequantize)
+{
+  effect->dequantize = *dequantize;
+  phong_effect_update_transforms(effect);
 }
 
 void phong_effect_set_light_pos(PhongEffect* effect, const Vec4* light_pos)
@@ -120,6 +130,32 @@ void phong_effect_vertex_shader(const PhongEffect* effect, const PhongEffectVert
   out->normal = mat4_vec_mul(&effect->world, &in_normal);
 }
 
+// Shades all of `streams` at once, a component of every vertex at a time.
+void phong_effect_streams_vertex_shader(const PhongEffect* effect,
+                                        const VertexStreams* streams,
+                                        PhongEffectVSOut out[])
+{
+  const size_t count = streams->num_vertices;
+  const size_t stride = sizeof(PhongEffectVSOut);
+  mat4_transform_streams(&effect->proj_world, streams->x, streams->y, streams->z, 1.0f, count, &out->pos, stride);
+  mat4_transform_streams(&effect->world, streams->x, streams->y, streams->z, 1.0f, count, &out->world_pos, stride);
+  mat4_transform_streams(&effect->world, streams->nx, streams->ny, streams->nz, 0.0f, count, &out->normal, stride);
+}
+
+// Decoding the position costs nothing, since the dequantization is part of the matrices.
+void phong_effect_packed_vertex_shader(const PhongEffect* effect,
+                                       const PhongEffectPackedVertex* in,
+                                       PhongEffectVSOut* out)
+{
+  const Vec4 in_pos = vec4_make(in->pos[0], in->pos[1], in->pos[2], 1.0f);
+  const Vec3 normal = normal_unpack_octahedral(in->normal);
+  const Vec4 in_normal = vec4_make(normal.x, normal.y, normal.z, 0.0f);
+
+  out->pos = mat4_vec_mul(&effect->packed_proj_world, &in_pos);
+  out->world_pos = mat4_vec_mul(&effect->packed_world, &in_pos);
+  out->normal = mat4_vec_mul(&effect->world, &in_normal);
+}
+
 void phong_effect_geometry_shader(const PhongEffect* effect,
                                   const PhongEffectVSOut* in0,
                                   const PhongEffectVSOut* in1,
@@ -198,3 +234,10 @@ Color phong_effect_pixel_shader(const PhongEffect* effect, const PhongEffectGSOu
 
   return ((Color)color.x << 24) | ((Color)color.y << 16) | ((Color)color.z << 8) | 255;
 }
+
+static void phong_effect_update_transforms(PhongEffect* effect)
+{
+  effect->proj_world = mat4_mul(&effect->projection, &effect->world);
+  effect->packed_world = mat4_mul(&effect->world, &effect->dequantize);
+  effect->packed_proj_world = mat4_mul(&effect->proj_world, &effect->dequantize);
+}
@@ -4,11 +4,14 @@
 #include "vector.h"
 #include "matrix.h"
 #include "graphics.h"
+#include "vertex_packing.h"
+#include "vertex_streams.h"
 #include "meshes/normal_mesh.h"
 
 #include <stddef.h>
 
 typedef NormalVertex PhongEffectVertex;
+typedef PackedNormalVertex PhongEffectPackedVertex;
 
 typedef struct
 {
@@ -36,6 +39,9 @@ typedef struct
   Mat4 world;
   Mat4 projection;
   Mat4 proj_world;
+  Mat4 dequantize;         // Maps packed vertex positions to object space
+  Mat4 packed_world;       // world * dequantize
+  Mat4 packed_proj_world;  // proj_world * dequantize
   Vec4 light_pos;
   Vec3 ambient_light;
   Vec3 diffuse_light;
@@ -54,6 +60,7 @@ PhongEffect phong_effect_make(const Graphics* graphics);
 
 void phong_effect_set_world(PhongEffect* effect, const Mat4* world);
 void phong_effect_set_projection(PhongEffect* effect, const Mat4* projection);
+void phong_effect_set_dequantize(PhongEffect* effect, const Mat4* dequantize);
 
 void phong_effect_set_light_pos(PhongEffect* effect, const Vec4* light_pos);
 void phong_effect_set_ambient_light(PhongEffect* effect, const Vec3* light);
@@ -65,6 +72,12 @@ void phong_effect_set_light_coefficients(PhongEffect* effect, float ambient, flo
 void phong_effect_set_specular_power(PhongEffect* effect, float power);
 
 void phong_effect_vertex_shader(const PhongEffect* effect, const PhongEffectVertex* in, PhongEffectVSOut* out);
+void phong_effect_streams_vertex_shader(const PhongEffect* effect,
+                                        const VertexStreams* streams,
+                                        PhongEffectVSOut out[]);
+void phong_effect_packed_vertex_shader(const PhongEffect* effect,
+                                       const PhongEffectPackedVertex* in,
+                                       PhongEffectVSOut* out);
 void phong_effect_geometry_shader(const PhongEffect* effect,
                                   const PhongEffectVSOut* in0,
                                   const PhongEffectVSOut* in1,
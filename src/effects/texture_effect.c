@@ -1,5 +1,7 @@
 #include "texture_effect.h"
 
+static void texture_effect_update_transforms(TextureEffect* effect);
+
 TextureEffectGSOut texture_effect_gsout_add(const TextureEffectGSOut* v, const TextureEffectGSOut* w)
 {
   return (TextureEffectGSOut){
@@ -47,19 +49,28 @@ TextureEffect texture_effect_make(const Graphics* graphics)
   return (TextureEffect){
     .graphics = graphics,
     .proj_world = mat4_identity(),
+    .dequantize = mat4_identity(),
+    .packed_proj_world = mat4_identity(),
   };
 }
 
 void texture_effect_set_world(TextureEffect* effect, const Mat4* world)
 {
   effect->world = *world;
-  effect->proj_world = mat4_mul(&effect->projection, &effect->world);
+  texture_effect_update_transforms(effect);
 }
 
 void texture_effect_set_projection(TextureEffect* effect, const Mat4* projection)
 {
   effect->projection = *projection;
-  effect->proj_world = mat4_mul(&effect->projection, &effect->world);
+  texture_effect_update_transforms(effect);
+}
+
+// Only needed for packed vertices, see `PositionQuantization`.
+void texture_effect_set_dequantize(TextureEffect* effect, const Mat4* dequantize)
+{
+  effect->dequantize = *dequantize;
+  texture_effect_update_transforms(effect);
 }
 
 void texture_effect_set_texture(TextureEffect* effect, const Texture* texture)
@@ -67,6 +78,11 @@ void texture_effect_set_texture(TextureEffect* effect, const Texture* texture)
   effect->texture = texture;
 }
 
+void texture_effect_set_virtual_texture(TextureEffect* effect, VirtualTexture* texture)
+{
+  effect->virtual_texture = texture;
+}
+
 void texture_effect_vertex_shader(const TextureEffect* effect, const TextureEffectVertex* in, TextureEffectVSOut* out)
 {
   const Vec4 in_pos = vec4_make(in->pos.x, in->pos.y, in->pos.z, 1.0f);
@@ -75,6 +91,30 @@ void texture_effect_vertex_shader(const TextureEffect* effect, const TextureEffe
   out->uv = in->uv;
 }
 
+// Shades all of `streams` at once.
+void texture_effect_streams_vertex_shader(const TextureEffect* effect,
+                                          const VertexStreams* streams,
+                                          TextureEffectVSOut out[])
+{
+  const size_t count = streams->num_vertices;
+  const size_t stride = sizeof(TextureEffectVSOut);
+  mat4_transform_streams(&effect->proj_world, streams->x, streams->y, streams->z, 1.0f, count, &out->pos, stride);
+
+  for (size_t i = 0; i < count; i++) {
+    out[i].uv = vec2_make(streams->u[i], streams->v[i]);
+  }
+}
+
+void texture_effect_packed_vertex_shader(const TextureEffect* effect,
+                                         const TextureEffectPackedVertex* in,
+                                         TextureEffectVSOut* out)
+{
+  const Vec4 in_pos = vec4_make(in->pos[0], in->pos[1], in->pos[2], 1.0f);
+  out->pos = mat4_vec_mul(&effect->packed_proj_world, &in_pos);
+
+  out->uv = vec2_make(half_to_float(in->uv[0]), half_to_float(in->uv[1]));
+}
+
 void texture_effect_geometry_shader(const TextureEffect* effect,
                                     const TextureEffectVSOut* in0,
                                     const TextureEffectVSOut* in1,
@@ -122,5 +162,15 @@ Color texture_effect_pixel_shader(const TextureEffect* effect, const TextureEffe
   const float z = 1.0f / in->pos.w;
   const float u = in->uv.x * z;
   const float v = in->uv.y * z;
+
+  if (effect->virtual_texture != NULL) {
+    return virtual_texture_uv_at(effect->virtual_texture, u, v);
+  }
   return texture_uv_at(effect->texture, u, v);
 }
+
+static void texture_effect_update_transforms(TextureEffect* effect)
+{
+  effect->proj_world = mat4_mul(&effect->projection, &effect->world);
+  effect->packed_proj_world = mat4_mul(&effect->proj_world, &effect->dequantize);
+}
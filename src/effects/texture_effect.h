@@ -5,11 +5,15 @@
 #include "matrix.h"
 #include "graphics.h"
 #include "texture.h"
+#include "vertex_packing.h"
+#include "vertex_streams.h"
+#include "virtual_texture.h"
 #include "meshes/texture_mesh.h"
 
 #include <stddef.h>
 
 typedef TextureVertex TextureEffectVertex;
+typedef PackedTextureVertex TextureEffectPackedVertex;
 
 typedef struct
 {
@@ -34,19 +38,30 @@ TextureEffectGSOut texture_effect_gsout_interpolate(const TextureEffectGSOut* v,
 typedef struct
 {
   const Texture* texture;
+  VirtualTexture* virtual_texture;  // Sampled instead of `texture` when set, which records feedback in it
   const Graphics* graphics;
   Mat4 world;
   Mat4 projection;
   Mat4 proj_world;
+  Mat4 dequantize;         // Maps packed vertex positions to object space
+  Mat4 packed_proj_world;  // proj_world * dequantize
 } TextureEffect;
 
 TextureEffect texture_effect_make(const Graphics* graphics);
 
 void texture_effect_set_world(TextureEffect* effect, const Mat4* world);
 void texture_effect_set_projection(TextureEffect* effect, const Mat4* projection);
+void texture_effect_set_dequantize(TextureEffect* effect, const Mat4* dequantize);
 void texture_effect_set_texture(TextureEffect* effect, const Texture* texture);
+void texture_effect_set_virtual_texture(TextureEffect* effect, VirtualTexture* texture);
 
 void texture_effect_vertex_shader(const TextureEffect* effect, const TextureEffectVertex* in, TextureEffectVSOut* out);
+void texture_effect_streams_vertex_shader(const TextureEffect* effect,
+                                          const VertexStreams* streams,
+                                          TextureEffectVSOut out[]);
+void texture_effect_packed_vertex_shader(const TextureEffect* effect,
+                                         const TextureEffectPackedVertex* in,
+                                         TextureEffectVSOut* out);
 void texture_effect_geometry_shader(const TextureEffect* effect,
                                     const TextureEffectVSOut* in0,
                                     const TextureEffectVSOut* in1,
@@ -0,0 +1,48 @@
+#include "frustum.h"
+
+#include <tgmath.h>
+
+// A point is inside the clip volume when -w <= x, y, z <= w, so each plane is the last row of the matrix plus or minus
+// one of the others.
+Frustum frustum_make(const Mat4* proj_world)
+{
+  const float (*m)[4] = proj_world->elements;
+
+  Frustum frustum;
+  for (int i = 0; i < 3; i++) {
+    for (int side = 0; side < 2; side++) {
+      const float sign = side == 0 ? 1.0f : -1.0f;
+      Vec4 plane = vec4_make(m[3][0] + sign * m[i][0],
+                             m[3][1] + sign * m[i][1],
+                             m[3][2] + sign * m[i][2],
+                             m[3][3] + sign * m[i][3]);
+
+      const float length = sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+      frustum.planes[2 * i + side] = vec4_make(plane.x / length, plane.y / length, plane.z / length, plane.w / length);
+    }
+  }
+  return frustum;
+}
+
+bool frustum_sphere_visible(const Frustum* frustum, const Vec3* center, float radius)
+{
+  for (int i = 0; i < 6; i++) {
+    const Vec4* plane = &frustum->planes[i];
+    if (plane->x * center->x + plane->y * center->y + plane->z * center->z + plane->w < -radius) return false;
+  }
+  return true;
+}
+
+// Only the corner of the box furthest along each plane's normal needs to be tested. Like the sphere test, this can
+// keep boxes that are outside the frustum near its corners, but never culls one that isn't.
+bool frustum_box_visible(const Frustum* frustum, const Vec3* min, const Vec3* max)
+{
+  for (int i = 0; i < 6; i++) {
+    const Vec4* plane = &frustum->planes[i];
+    const float x = plane->x >= 0.0f ? max->x : min->x;
+    const float y = plane->y >= 0.0f ? max->y : min->y;
+    const float z = plane->z >= 0.0f ? max->z : min->z;
+    if (plane->x * x + plane->y * y + plane->z * z + plane->w < 0.0f) return false;
+  }
+  return true;
+}
@@ -0,0 +1,21 @@
+#ifndef FRUSTUM_H_
+#define FRUSTUM_H_
+
+#include "vector.h"
+#include "matrix.h"
+
+#include <stdbool.h>
+
+// The six clipping planes of a transformation into clip space, in the space the transformation starts from. A point p
+// is inside a plane when dot(plane.xyz, p) + plane.w >= 0. The planes are normalized, so that this is also the
+// distance.
+typedef struct
+{
+  Vec4 planes[6];
+} Frustum;
+
+Frustum frustum_make(const Mat4* proj_world);
+bool frustum_sphere_visible(const Frustum* frustum, const Vec3* center, float radius);
+bool frustum_box_visible(const Frustum* frustum, const Vec3* min, const Vec3* max);
+
+#endif
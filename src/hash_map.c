@@ -0,0 +1,91 @@
+#include "hash_map.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void hash_map_allocate(HashMap* map, size_t capacity);
+static size_t hash_map_probe(const HashMap* map, const void* key);
+static void hash_map_grow(HashMap* map);
+
+HashMap hash_map_make(size_t key_size, uint64_t hash(const void*), bool equal(const void*, const void*))
+{
+  HashMap map = {
+    .size = 0,
+    .key_size = key_size,
+    .hash = hash,
+    .equal = equal,
+  };
+  hash_map_allocate(&map, 32);
+  return map;
+}
+
+void hash_map_destroy(HashMap* map)
+{
+  free(map->keys);
+  free(map->values);
+  free(map->occupied);
+  map->keys = NULL;
+  map->values = NULL;
+  map->occupied = NULL;
+  map->size = 0;
+  map->capacity = 0;
+}
+
+bool hash_map_find(const HashMap* map, const void* key, size_t* value)
+{
+  const size_t slot = hash_map_probe(map, key);
+  if (!map->occupied[slot]) return false;
+  *value = map->values[slot];
+  return true;
+}
+
+// Replaces the value if `key` is already present.
+void hash_map_insert(HashMap* map, const void* key, size_t value)
+{
+  // Keep the load factor at or below one half, so that probe sequences stay short.
+  if (2 * (map->size + 1) > map->capacity) {
+    hash_map_grow(map);
+  }
+
+  const size_t slot = hash_map_probe(map, key);
+  if (!map->occupied[slot]) {
+    memcpy(&map->keys[slot * map->key_size], key, map->key_size);
+    map->occupied[slot] = true;
+    map->size++;
+  }
+  map->values[slot] = value;
+}
+
+static void hash_map_allocate(HashMap* map, size_t capacity)
+{
+  map->keys = malloc(capacity * map->key_size);
+  map->values = malloc(capacity * sizeof(size_t));
+  map->occupied = calloc(capacity, sizeof(bool));
+  map->capacity = capacity;
+}
+
+// Returns the slot holding `key`, or the empty slot where it would go.
+static size_t hash_map_probe(const HashMap* map, const void* key)
+{
+  const size_t mask = map->capacity - 1;
+  size_t slot = map->hash(key) & mask;
+  while (map->occupied[slot] && !map->equal(&map->keys[slot * map->key_size], key)) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+static void hash_map_grow(HashMap* map)
+{
+  HashMap old = *map;
+  hash_map_allocate(map, 2 * old.capacity);
+  map->size = 0;
+
+  for (size_t i = 0; i < old.capacity; i++) {
+    if (old.occupied[i]) {
+      hash_map_insert(map, &old.keys[i * old.key_size], old.values[i]);
+    }
+  }
+
+  hash_map_destroy(&old);
+}
@@ -0,0 +1,37 @@
+#ifndef HASH_MAP_H_
+#define HASH_MAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Open-addressing (linear probing) map from fixed-size keys to indices. Keys are copied into the map.
+typedef struct
+{
+  unsigned char* keys;
+  size_t* values;
+  bool* occupied;
+  size_t size;
+  size_t capacity;  // Always a power of two
+  size_t key_size;  // Size of key type in bytes
+  uint64_t (*hash)(const void*);
+  bool (*equal)(const void*, const void*);
+} HashMap;
+
+HashMap hash_map_make(size_t key_size, uint64_t hash(const void*), bool equal(const void*, const void*));
+void hash_map_destroy(HashMap* map);
+bool hash_map_find(const HashMap* map, const void* key, size_t* value);
+void hash_map_insert(HashMap* map, const void* key, size_t value);
+
+// Finalizer from splitmix64, for turning combined integer keys into well-distributed hashes.
+static inline uint64_t hash_mix(uint64_t x)
+{
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111eb;
+  x ^= x >> 31;
+  return x;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#include "index_buffer.h"
+
+#include <stdlib.h>
+
+// Returns 0 if there are too many vertices for any index width.
+size_t index_size_for_vertex_count(size_t num_vertices)
+{
+  if (num_vertices > INDEX_BUFFER_MAX_VERTICES) return 0;
+  return num_vertices <= UINT16_MAX ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+// Copies `indices` into a new index buffer of the right width for `num_vertices` vertices. Markers for that width (see
+// `index_restart_for_size`) are copied as they are.
+DynList index_buffer_make(const size_t indices[], size_t num_indices, size_t num_vertices)
+{
+  assert(num_vertices <= INDEX_BUFFER_MAX_VERTICES);
+  DynList buffer = dyn_list_make(index_size_for_vertex_count(num_vertices));
+  dyn_list_reserve(&buffer, num_indices);
+  buffer.size = num_indices;
+
+  if (buffer.type_size == sizeof(uint16_t)) {
+    uint16_t* dest = (uint16_t*)buffer.buffer;
+    for (size_t i = 0; i < num_indices; i++) {
+      assert(indices[i] < num_vertices || indices[i] == UINT16_MAX);
+      dest[i] = indices[i];
+    }
+  } else {
+    uint32_t* dest = (uint32_t*)buffer.buffer;
+    for (size_t i = 0; i < num_indices; i++) {
+      assert(indices[i] < num_vertices || indices[i] == UINT32_MAX);
+      dest[i] = indices[i];
+    }
+  }
+
+  return buffer;
+}
+
+// Returns a newly allocated array of `indices->size` full width indices.
+size_t* index_buffer_expand(const DynList* indices)
+{
+  size_t* expanded = malloc(indices->size * sizeof(size_t));
+  for (size_t i = 0; i < indices->size; i++) {
+    expanded[i] = index_buffer_at(indices, i);
+  }
+  return expanded;
+}
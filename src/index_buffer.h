@@ -0,0 +1,49 @@
+#ifndef INDEX_BUFFER_H_
+#define INDEX_BUFFER_H_
+
+#include "dynlist.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+// Index buffers are `DynList`s of `uint16_t` or `uint32_t`, whichever is the smallest that can address every vertex.
+// The largest value of each width is never used as an index, so that it remains free as a marker. So at most
+// `INDEX_BUFFER_MAX_VERTICES` vertices can be addressed.
+//
+// Strips and fans are separated by that marker: after it, the next two indices start a new strip or fan.
+#define INDEX_BUFFER_MAX_VERTICES ((size_t)UINT32_MAX)
+
+typedef enum {
+  PRIMITIVE_TRIANGLE_LIST,
+  PRIMITIVE_TRIANGLE_STRIP,
+  PRIMITIVE_TRIANGLE_FAN,
+} PrimitiveTopology;
+
+size_t index_size_for_vertex_count(size_t num_vertices);
+DynList index_buffer_make(const size_t indices[], size_t num_indices, size_t num_vertices);
+size_t* index_buffer_expand(const DynList* indices);
+
+static inline size_t index_restart_for_size(size_t index_size)
+{
+  return index_size == sizeof(uint16_t) ? UINT16_MAX : UINT32_MAX;
+}
+
+static inline size_t index_buffer_at(const DynList* indices, size_t i)
+{
+  assert(i < indices->size);
+  if (indices->type_size == sizeof(uint16_t)) return ((const uint16_t*)indices->buffer)[i];
+  return ((const uint32_t*)indices->buffer)[i];
+}
+
+static inline void index_buffer_set(DynList* indices, size_t i, size_t index)
+{
+  assert(i < indices->size);
+  if (indices->type_size == sizeof(uint16_t)) {
+    ((uint16_t*)indices->buffer)[i] = index;
+  } else {
+    ((uint32_t*)indices->buffer)[i] = index;
+  }
+}
+
+#endif
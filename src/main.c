@@ -6,7 +6,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-static void update_fps_counter(SDL_Window* window);
+static void update_fps_counter(SDL_Window* window, const PipelineStats* stats);
 
 int main(void)
 {
@@ -52,7 +52,7 @@ int main(void)
     const float dt = current_time - last_time;
     last_time = current_time;
 
-    update_fps_counter(window);
+    update_fps_counter(window, &scene.stats);
 
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
@@ -86,7 +86,8 @@ int main(void)
   return EXIT_SUCCESS;
 }
 
-static void update_fps_counter(SDL_Window* window)
+// The pipeline stats are those of the frame drawn last.
+static void update_fps_counter(SDL_Window* window, const PipelineStats* stats)
 {
   static uint32_t last_time = 0;
   static unsigned int frame_count = 0;
@@ -97,7 +98,13 @@ static void update_fps_counter(SDL_Window* window)
 
   if (delta_time >= 500) {
     char title[128];
-    snprintf(title, sizeof(title), "%.2f FPS", (float)frame_count / delta_time * 1000.0f);
+    snprintf(title,
+             sizeof(title),
+             "%.2f FPS, %zu meshes drawn, %zu culled, %zu occluded",
+             (float)frame_count / delta_time * 1000.0f,
+             stats->meshes_drawn,
+             stats->meshes_culled,
+             stats->meshes_occluded);
     SDL_SetWindowTitle(window, title);
     last_time = current_time;
     frame_count = 0;
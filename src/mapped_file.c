@@ -0,0 +1,56 @@
+#define _POSIX_C_SOURCE 200809L  // mmap, open, fstat
+
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile mapped_file_make(void)
+{
+  return (MappedFile){
+    .data = NULL,
+    .size = 0,
+  };
+}
+
+// Empty files can't be mapped; opening one succeeds, but leaves `data` as NULL.
+bool mapped_file_open(MappedFile* file, const char* path)
+{
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    return false;
+  }
+  if (info.st_size == 0) {
+    close(fd);
+    *file = mapped_file_make();
+    return true;
+  }
+
+  void* data = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return false;
+
+  file->data = data;
+  file->size = info.st_size;
+  return true;
+}
+
+void mapped_file_close(MappedFile* file)
+{
+  if (file->data != NULL) {
+    munmap(file->data, file->size);
+  }
+  file->data = NULL;
+  file->size = 0;
+}
+
+bool mapped_file_is_open(const MappedFile* file)
+{
+  return file->data != NULL;
+}
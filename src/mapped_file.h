@@ -0,0 +1,19 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// A file mapped into memory. The mapping is private, so writes to it are never carried through to the file.
+typedef struct
+{
+  unsigned char* data;
+  size_t size;
+} MappedFile;
+
+MappedFile mapped_file_make(void);
+bool mapped_file_open(MappedFile* file, const char* path);
+void mapped_file_close(MappedFile* file);
+bool mapped_file_is_open(const MappedFile* file);
+
+#endif
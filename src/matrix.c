@@ -4,6 +4,23 @@
 
 #include <tgmath.h>
 
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+// The AVX version of `mat4_transform_streams` is built whatever the compiler flags, and used if the CPU supports it.
+#if defined(__SSE__) && defined(__GNUC__)
+#define TRANSFORM_STREAMS_AVX
+__attribute__((target("avx"))) static size_t mat4_transform_streams_avx(const Mat4* a,
+                                                                         const float x[],
+                                                                         const float y[],
+                                                                         const float z[],
+                                                                         float w,
+                                                                         size_t count,
+                                                                         unsigned char* dest,
+                                                                         size_t out_stride);
+#endif
+
 Mat3 mat3_zero(void)
 {
   Mat3 result;
@@ -126,6 +143,27 @@ Vec3 mat3_vec_mul(const Mat3* a, const Vec3* v)
   return result;
 }
 
+// Assumes `a` is invertible.
+Mat3 mat3_inverse(const Mat3* a)
+{
+  const float (*m)[3] = a->elements;
+
+  Mat3 result;
+  result.elements[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+  result.elements[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+  result.elements[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+  result.elements[1][0] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+  result.elements[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+  result.elements[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+  result.elements[2][0] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+  result.elements[2][1] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+  result.elements[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+  const float determinant = m[0][0] * result.elements[0][0] + m[0][1] * result.elements[1][0] +
+                            m[0][2] * result.elements[2][0];
+  return mat3_scalar_mul(&result, 1.0f / determinant);
+}
+
 Mat4 mat4_zero(void)
 {
   Mat4 result;
@@ -259,6 +297,30 @@ Mat4 mat4_scalar_mul(const Mat4* a, float c)
   return result;
 }
 
+// Inverts a matrix whose bottom row is (0, 0, 0, 1), i.e. a linear transformation followed by a translation.
+Mat4 mat4_affine_inverse(const Mat4* a)
+{
+  Mat3 linear;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      linear.elements[i][j] = a->elements[i][j];
+    }
+  }
+  const Mat3 inverse = mat3_inverse(&linear);
+
+  const Vec3 translation = vec3_make(a->elements[0][3], a->elements[1][3], a->elements[2][3]);
+  const Vec3 inverse_translation = mat3_vec_mul(&inverse, &translation);
+
+  Mat4 result = mat4_identity();
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      result.elements[i][j] = inverse.elements[i][j];
+    }
+    result.elements[i][3] = -inverse_translation.elements[i];
+  }
+  return result;
+}
+
 Vec4 mat4_vec_mul(const Mat4* a, const Vec4* v)
 {
   Vec4 result;
@@ -271,3 +333,108 @@ Vec4 mat4_vec_mul(const Mat4* a, const Vec4* v)
   }
   return result;
 }
+
+// Transforms the vectors (x[i], y[i], z[i], w) for i < `count`, and stores the results `out_stride` bytes apart
+// starting at `out`, so that they can go straight into an array of structs. Does 8 vectors at a time with AVX, and
+// otherwise 4 with SSE.
+void mat4_transform_streams(const Mat4* a,
+                            const float x[],
+                            const float y[],
+                            const float z[],
+                            float w,
+                            size_t count,
+                            Vec4* out,
+                            size_t out_stride)
+{
+  unsigned char* dest = (unsigned char*)out;
+  size_t i = 0;
+
+#if defined(TRANSFORM_STREAMS_AVX)
+  if (__builtin_cpu_supports("avx")) i = mat4_transform_streams_avx(a, x, y, z, w, count, dest, out_stride);
+#endif
+
+#if defined(__SSE__)
+  __m128 rows[4][4];
+  for (int r = 0; r < 4; r++) {
+    for (int c = 0; c < 4; c++) {
+      rows[r][c] = _mm_set1_ps(a->elements[r][c]);
+    }
+  }
+
+  for (; i + 4 <= count; i += 4) {
+    const __m128 vx = _mm_loadu_ps(&x[i]);
+    const __m128 vy = _mm_loadu_ps(&y[i]);
+    const __m128 vz = _mm_loadu_ps(&z[i]);
+
+    __m128 results[4];
+    for (int r = 0; r < 4; r++) {
+      const __m128 xy = _mm_add_ps(_mm_mul_ps(rows[r][0], vx), _mm_mul_ps(rows[r][1], vy));
+      const __m128 zw = _mm_add_ps(_mm_mul_ps(rows[r][2], vz), _mm_mul_ps(rows[r][3], _mm_set1_ps(w)));
+      results[r] = _mm_add_ps(xy, zw);
+    }
+
+    _MM_TRANSPOSE4_PS(results[0], results[1], results[2], results[3]);
+    for (size_t k = 0; k < 4; k++) {
+      _mm_storeu_ps((float*)(dest + (i + k) * out_stride), results[k]);
+    }
+  }
+#endif
+
+  for (; i < count; i++) {
+    const Vec4 v = vec4_make(x[i], y[i], z[i], w);
+    *(Vec4*)(dest + i * out_stride) = mat4_vec_mul(a, &v);
+  }
+}
+
+#if defined(TRANSFORM_STREAMS_AVX)
+// Transforms as many vectors as it can 8 at a time, and returns how many that was.
+__attribute__((target("avx"))) static size_t mat4_transform_streams_avx(const Mat4* a,
+                                                                         const float x[],
+                                                                         const float y[],
+                                                                         const float z[],
+                                                                         float w,
+                                                                         size_t count,
+                                                                         unsigned char* dest,
+                                                                         size_t out_stride)
+{
+  size_t i = 0;
+
+  __m256 rows[4][4];
+  for (int r = 0; r < 4; r++) {
+    for (int c = 0; c < 4; c++) {
+      rows[r][c] = _mm256_set1_ps(a->elements[r][c]);
+    }
+  }
+
+  for (; i + 8 <= count; i += 8) {
+    const __m256 vx = _mm256_loadu_ps(&x[i]);
+    const __m256 vy = _mm256_loadu_ps(&y[i]);
+    const __m256 vz = _mm256_loadu_ps(&z[i]);
+
+    __m256 results[4];
+    for (int r = 0; r < 4; r++) {
+      const __m256 xy = _mm256_add_ps(_mm256_mul_ps(rows[r][0], vx), _mm256_mul_ps(rows[r][1], vy));
+      const __m256 zw = _mm256_add_ps(_mm256_mul_ps(rows[r][2], vz), _mm256_mul_ps(rows[r][3], _mm256_set1_ps(w)));
+      results[r] = _mm256_add_ps(xy, zw);
+    }
+
+    // Transposes to one vector per 128-bit half: vector k in the low half of `vectors[k]`, and k + 4 in the high one.
+    const __m256 xy_low = _mm256_unpacklo_ps(results[0], results[1]);
+    const __m256 xy_high = _mm256_unpackhi_ps(results[0], results[1]);
+    const __m256 zw_low = _mm256_unpacklo_ps(results[2], results[3]);
+    const __m256 zw_high = _mm256_unpackhi_ps(results[2], results[3]);
+    const __m256 vectors[4] = {
+      _mm256_shuffle_ps(xy_low, zw_low, _MM_SHUFFLE(1, 0, 1, 0)),
+      _mm256_shuffle_ps(xy_low, zw_low, _MM_SHUFFLE(3, 2, 3, 2)),
+      _mm256_shuffle_ps(xy_high, zw_high, _MM_SHUFFLE(1, 0, 1, 0)),
+      _mm256_shuffle_ps(xy_high, zw_high, _MM_SHUFFLE(3, 2, 3, 2)),
+    };
+    for (size_t k = 0; k < 4; k++) {
+      _mm_storeu_ps((float*)(dest + (i + k) * out_stride), _mm256_castps256_ps128(vectors[k]));
+      _mm_storeu_ps((float*)(dest + (i + k + 4) * out_stride), _mm256_extractf128_ps(vectors[k], 1));
+    }
+  }
+
+  return i;
+}
+#endif
@@ -3,6 +3,8 @@
 
 #include "vector.h"
 
+#include <stddef.h>
+
 typedef struct
 {
   float elements[3][3];
@@ -18,6 +20,7 @@ Mat3 mat3_sub(const Mat3* a, const Mat3* b);
 Mat3 mat3_mul(const Mat3* a, const Mat3* b);
 Mat3 mat3_scalar_mul(const Mat3* a, float c);
 Vec3 mat3_vec_mul(const Mat3* a, const Vec3* v);
+Mat3 mat3_inverse(const Mat3* a);
 
 typedef struct
 {
@@ -35,6 +38,15 @@ Mat4 mat4_add(const Mat4* a, const Mat4* b);
 Mat4 mat4_sub(const Mat4* a, const Mat4* b);
 Mat4 mat4_mul(const Mat4* a, const Mat4* b);
 Mat4 mat4_scalar_mul(const Mat4* a, float c);
+Mat4 mat4_affine_inverse(const Mat4* a);
 Vec4 mat4_vec_mul(const Mat4* a, const Vec4* v);
+void mat4_transform_streams(const Mat4* a,
+                            const float x[],
+                            const float y[],
+                            const float z[],
+                            float w,
+                            size_t count,
+                            Vec4* out,
+                            size_t out_stride);
 
 #endif
@@ -0,0 +1,171 @@
+#define _POSIX_C_SOURCE 200809L  // stat
+
+#include "mesh_cache.h"
+
+#include "index_buffer.h"
+#include "meshlet.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define MESH_CACHE_MAGIC     "BLOOPMSH"
+#define MESH_CACHE_VERSION   8
+#define MESH_CACHE_EXTENSION ".meshcache"
+
+static bool mesh_cache_contents_valid(const MappedFile* cache, const MeshCacheHeader* header);
+static bool write_section(FILE* output, size_t* position, size_t offset, const void* data, size_t size);
+static size_t align_up(size_t offset);
+
+// Returns `<path>.<type_name>.meshcache`, since different mesh types built from the same file need their own cache.
+char* mesh_cache_path(const char* path, const char* type_name)
+{
+  char* cache_path = malloc(strlen(path) + strlen(type_name) + strlen(MESH_CACHE_EXTENSION) + 2);
+  strcpy(cache_path, path);
+  strcat(cache_path, ".");
+  strcat(cache_path, type_name);
+  strcat(cache_path, MESH_CACHE_EXTENSION);
+  return cache_path;
+}
+
+// Fills in everything but the counts, index size and bounds. The cache is tied to the source by its size and
+// modification time, which, unlike a hash of its contents, doesn't require reading the source.
+bool mesh_cache_header_make(MeshCacheHeader* header, const char* source_path, size_t vertex_size, uint32_t flags)
+{
+  struct stat info;
+  if (stat(source_path, &info) != 0) return false;
+
+  *header = (MeshCacheHeader){
+    .version = MESH_CACHE_VERSION,
+    .vertex_size = vertex_size,
+    .flags = flags,
+    .source_size = info.st_size,
+    .source_mtime = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec,
+  };
+  memcpy(header->magic, MESH_CACHE_MAGIC, sizeof(header->magic));
+  return true;
+}
+
+// Maps the cache file if it matches everything in `expected` but the counts, index size and bounds, and its indices
+// and meshlets stay within the mesh.
+bool mesh_cache_open(MappedFile* cache, const char* cache_path, const MeshCacheHeader* expected)
+{
+  if (!mapped_file_open(cache, cache_path)) return false;
+
+  const MeshCacheHeader* header = (const MeshCacheHeader*)cache->data;
+  bool valid = cache->size >= sizeof(MeshCacheHeader) &&
+               memcmp(header->magic, expected->magic, sizeof(header->magic)) == 0 &&
+               header->version == expected->version && header->vertex_size == expected->vertex_size &&
+               header->flags == expected->flags && header->source_size == expected->source_size &&
+               header->source_mtime == expected->source_mtime;
+  valid = valid && header->num_vertices <= cache->size / header->vertex_size && header->index_size != 0 &&
+          header->index_size == index_size_for_vertex_count(header->num_vertices) &&
+          header->num_indices <= cache->size / header->index_size &&
+          header->num_meshlets <= cache->size / sizeof(Meshlet) &&
+          cache->size >= mesh_cache_size(header);
+  valid = valid && mesh_cache_contents_valid(cache, header);
+
+  if (!valid) {
+    mapped_file_close(cache);
+    return false;
+  }
+  return true;
+}
+
+// Failing to write the cache isn't an error, the mesh is simply processed again next time.
+void mesh_cache_write(const char* cache_path,
+                      const MeshCacheHeader* header,
+                      const void* vertices,
+                      const void* indices,
+                      const void* meshlets)
+{
+  // Write to a temporary file first, so that a partially written cache is never picked up.
+  char* temp_path = malloc(strlen(cache_path) + 5);
+  strcpy(temp_path, cache_path);
+  strcat(temp_path, ".tmp");
+
+  FILE* output = fopen(temp_path, "wb");
+  if (output == NULL) {
+    free(temp_path);
+    return;
+  }
+
+  size_t position = 0;
+  const bool written =
+    write_section(output, &position, 0, header, sizeof(MeshCacheHeader)) &&
+    write_section(
+      output, &position, mesh_cache_vertices_offset(), vertices, header->num_vertices * header->vertex_size) &&
+    write_section(
+      output, &position, mesh_cache_indices_offset(header), indices, header->num_indices * header->index_size) &&
+    write_section(
+      output, &position, mesh_cache_meshlets_offset(header), meshlets, header->num_meshlets * sizeof(Meshlet));
+  if (fclose(output) == 0 && written) {
+    rename(temp_path, cache_path);
+  } else {
+    remove(temp_path);
+  }
+
+  free(temp_path);
+}
+
+size_t mesh_cache_vertices_offset(void)
+{
+  return align_up(sizeof(MeshCacheHeader));
+}
+
+size_t mesh_cache_indices_offset(const MeshCacheHeader* header)
+{
+  return align_up(mesh_cache_vertices_offset() + header->num_vertices * header->vertex_size);
+}
+
+size_t mesh_cache_meshlets_offset(const MeshCacheHeader* header)
+{
+  return align_up(mesh_cache_indices_offset(header) + header->num_indices * header->index_size);
+}
+
+size_t mesh_cache_size(const MeshCacheHeader* header)
+{
+  return mesh_cache_meshlets_offset(header) + header->num_meshlets * sizeof(Meshlet);
+}
+
+// Cached meshes are triangle lists.
+static bool mesh_cache_contents_valid(const MappedFile* cache, const MeshCacheHeader* header)
+{
+  if (header->num_indices % 3 != 0) return false;
+
+  const DynList indices =
+    dyn_list_make_view(cache->data + mesh_cache_indices_offset(header), header->num_indices, header->index_size);
+  for (size_t i = 0; i < indices.size; i++) {
+    if (index_buffer_at(&indices, i) >= header->num_vertices) return false;
+  }
+
+  const size_t num_triangles = header->num_indices / 3;
+  const Meshlet* meshlets = (const Meshlet*)(cache->data + mesh_cache_meshlets_offset(header));
+  for (size_t i = 0; i < header->num_meshlets; i++) {
+    const Meshlet* meshlet = &meshlets[i];
+    if (meshlet->first_triangle > num_triangles || meshlet->num_triangles > num_triangles - meshlet->first_triangle ||
+        meshlet->first_index != 3 * (size_t)meshlet->first_triangle ||
+        meshlet->num_indices != 3 * (size_t)meshlet->num_triangles) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Pads the file with zeros up to `offset` and writes `size` bytes of `data` there.
+static bool write_section(FILE* output, size_t* position, size_t offset, const void* data, size_t size)
+{
+  static const unsigned char padding[MESH_CACHE_ALIGNMENT];
+
+  const size_t padding_size = offset - *position;
+  if (fwrite(padding, 1, padding_size, output) != padding_size || fwrite(data, 1, size, output) != size) return false;
+
+  *position = offset + size;
+  return true;
+}
+
+static size_t align_up(size_t offset)
+{
+  return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+}
@@ -0,0 +1,52 @@
+#ifndef MESH_CACHE_H_
+#define MESH_CACHE_H_
+
+#include "mapped_file.h"
+#include "mesh_optimizer.h"
+#include "vector.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Processed meshes are cached next to their source file, in exactly the layout the mesh uses in memory, so that they
+// can be mapped straight back in. A cache file is the header, followed by the vertex, index and meshlet arrays, each
+// aligned to a cache line. Finalized meshes keep the same layout in memory (see `mesh_finalize`).
+#define MESH_CACHE_ALIGNMENT 64
+
+#define MESH_CACHE_LOAD_UVS     (1 << 0)
+#define MESH_CACHE_LOAD_NORMALS (1 << 1)
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t vertex_size;
+  uint32_t index_size;
+  uint32_t flags;
+  uint64_t source_size;
+  int64_t source_mtime;  // Nanoseconds
+  uint64_t num_vertices;
+  uint64_t num_indices;
+  uint64_t num_meshlets;
+  Vec3 bounds_min;
+  Vec3 bounds_max;
+  Vec3 bounds_center;
+  float bounds_radius;
+  MeshOptimizationStats optimization;
+} MeshCacheHeader;
+
+char* mesh_cache_path(const char* path, const char* type_name);
+bool mesh_cache_header_make(MeshCacheHeader* header, const char* source_path, size_t vertex_size, uint32_t flags);
+bool mesh_cache_open(MappedFile* cache, const char* cache_path, const MeshCacheHeader* expected);
+void mesh_cache_write(const char* cache_path,
+                      const MeshCacheHeader* header,
+                      const void* vertices,
+                      const void* indices,
+                      const void* meshlets);
+size_t mesh_cache_vertices_offset(void);
+size_t mesh_cache_indices_offset(const MeshCacheHeader* header);
+size_t mesh_cache_meshlets_offset(const MeshCacheHeader* header);
+size_t mesh_cache_size(const MeshCacheHeader* header);
+
+#endif
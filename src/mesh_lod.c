@@ -0,0 +1,132 @@
+#include "mesh_lod.h"
+
+#include "index_buffer.h"
+#include "meshlet.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+
+#include <stdlib.h>
+#include <tgmath.h>
+
+// Builds a level for each of `ratios`, the fractions of the full mesh's triangles to keep, which should be decreasing.
+// Each level is simplified from the previous one, which keeps building the chain cheap even for large meshes. The
+// chain stops early once a level can't be simplified any further.
+DynList mesh_lods_build(const void* vertices,
+                        size_t num_vertices,
+                        size_t vertex_size,
+                        size_t position_offset,
+                        const DynList* indices,
+                        const float ratios[],
+                        size_t num_ratios)
+{
+  DynList lods = dyn_list_make(sizeof(MeshLod));
+
+  const unsigned char* source_vertices = vertices;
+  size_t source_num_vertices = num_vertices;
+  size_t* source_indices = index_buffer_expand(indices);
+  size_t source_num_indices = indices->size;
+  float error = 0.0f;
+
+  for (size_t i = 0; i < num_ratios; i++) {
+    const size_t target_num_indices = 3 * (size_t)(ratios[i] * (indices->size / 3));
+
+    float simplify_error;
+    size_t* lod_indices = malloc(source_num_indices * sizeof(size_t));
+    const size_t lod_num_indices = mesh_simplify(lod_indices,
+                                                 source_indices,
+                                                 source_num_indices,
+                                                 source_vertices + position_offset,
+                                                 vertex_size,
+                                                 source_num_vertices,
+                                                 target_num_indices,
+                                                 &simplify_error);
+    if (lod_num_indices == source_num_indices) {
+      free(lod_indices);
+      break;
+    }
+
+    // Renumbering the vertices in first use order moves the unused ones to the end, where they are cut off.
+    MeshLod lod = {
+      .vertices = dyn_list_make(vertex_size),
+      .error = error + simplify_error,
+    };
+    dyn_list_append(&lod.vertices, source_vertices, source_num_vertices);
+    mesh_optimize_vertex_order(lod.vertices.buffer, source_num_vertices, vertex_size, lod_indices, lod_num_indices);
+
+    size_t num_used_vertices = 0;
+    for (size_t j = 0; j < lod_num_indices; j++) {
+      if (lod_indices[j] >= num_used_vertices) num_used_vertices = lod_indices[j] + 1;
+    }
+    lod.vertices.size = num_used_vertices;
+
+    lod.indices = index_buffer_make(lod_indices, lod_num_indices, num_used_vertices);
+    lod.meshlets = meshlets_build(lod.vertices.buffer + position_offset, vertex_size, &lod.indices, num_used_vertices);
+    dyn_list_shrink_to_fit(&lod.vertices);
+    dyn_list_shrink_to_fit(&lod.indices);
+    dyn_list_shrink_to_fit(&lod.meshlets);
+    dyn_list_add(&lods, &lod);
+
+    free(source_indices);
+    source_vertices = lod.vertices.buffer;
+    source_num_vertices = num_used_vertices;
+    source_indices = lod_indices;
+    source_num_indices = lod_num_indices;
+    error = lod.error;
+  }
+
+  free(source_indices);
+  return lods;
+}
+
+void mesh_lods_destroy(DynList* lods)
+{
+  for (size_t i = 0; i < lods->size; i++) {
+    MeshLod* lod = dyn_list_mutable_at(lods, i);
+    dyn_list_destroy(&lod->vertices);
+    dyn_list_destroy(&lod->indices);
+    dyn_list_destroy(&lod->meshlets);
+  }
+  dyn_list_destroy(lods);
+}
+
+// Picks the coarsest level whose error, projected onto the screen at the nearest point of the mesh's bounding sphere,
+// covers at most `max_pixel_error` pixels. Returns 0 for the full detail mesh, and `i + 1` for `lods[i]`.
+size_t mesh_lod_select(const DynList* lods,
+                       const Vec3* bounds_min,
+                       const Vec3* bounds_max,
+                       const Mat4* world,
+                       const Mat4* projection,
+                       int screen_height,
+                       float max_pixel_error)
+{
+  if (lods->size == 0) return 0;
+
+  const Vec3 center = vec3_make((bounds_min->x + bounds_max->x) / 2.0f,
+                                (bounds_min->y + bounds_max->y) / 2.0f,
+                                (bounds_min->z + bounds_max->z) / 2.0f);
+  const Vec3 half_extent = vec3_sub(bounds_max, &center);
+  const float radius = vec3_length(&half_extent);
+
+  // Object space lengths are scaled by at most the longest basis vector of `world`.
+  float scale = 0.0f;
+  for (size_t j = 0; j < 3; j++) {
+    const Vec3 axis = vec3_make(world->elements[0][j], world->elements[1][j], world->elements[2][j]);
+    scale = fmax(scale, vec3_length(&axis));
+  }
+
+  const Vec4 object_center = vec4_make(center.x, center.y, center.z, 1.0f);
+  const Vec4 view_center = mat4_vec_mul(world, &object_center);
+  const Vec3 offset = vec3_make(view_center.x, view_center.y, view_center.z);
+  const float distance = vec3_length(&offset) - radius * scale;
+  if (distance <= 0.0f) return 0;
+
+  const float pixels_per_unit = projection->elements[1][1] * screen_height / 2.0f / distance;
+
+  size_t level = 0;
+  while (level < lods->size) {
+    const MeshLod* lod = dyn_list_at(lods, level);
+    if (lod->error * scale * pixels_per_unit > max_pixel_error) break;
+    level++;
+  }
+  return level;
+}
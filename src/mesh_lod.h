@@ -0,0 +1,35 @@
+#ifndef MESH_LOD_H_
+#define MESH_LOD_H_
+
+#include "dynlist.h"
+#include "matrix.h"
+#include "vector.h"
+
+#include <stddef.h>
+
+// A simplified version of a mesh, with its own copy of the vertices it still uses.
+typedef struct
+{
+  DynList vertices;
+  DynList indices;   // See `index_buffer.h`
+  DynList meshlets;  // Meshlet, covering all triangles in order
+  float error;       // Estimated distance from the full detail surface, in object space
+} MeshLod;
+
+DynList mesh_lods_build(const void* vertices,
+                        size_t num_vertices,
+                        size_t vertex_size,
+                        size_t position_offset,
+                        const DynList* indices,
+                        const float ratios[],
+                        size_t num_ratios);
+void mesh_lods_destroy(DynList* lods);
+size_t mesh_lod_select(const DynList* lods,
+                       const Vec3* bounds_min,
+                       const Vec3* bounds_max,
+                       const Mat4* world,
+                       const Mat4* projection,
+                       int screen_height,
+                       float max_pixel_error);
+
+#endif
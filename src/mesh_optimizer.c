@@ -0,0 +1,248 @@
+#include "mesh_optimizer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <tgmath.h>
+
+// Parameters of Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+#define VERTEX_CACHE_SIZE   32
+#define CACHE_DECAY_POWER   1.5f
+#define LAST_TRIANGLE_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+
+// Cache line misses are counted against a 32 KiB, 8-way set associative cache with 64 byte lines.
+#define CACHE_LINE_SIZE 64
+#define CACHE_NUM_SETS  64
+#define CACHE_NUM_WAYS  8
+
+#define NO_TRIANGLE SIZE_MAX
+
+static float vertex_score(int cache_position, size_t remaining_triangles);
+
+void mesh_optimize(void* vertices,
+                   size_t num_vertices,
+                   size_t vertex_size,
+                   size_t indices[],
+                   size_t num_indices,
+                   MeshOptimizationStats* stats)
+{
+  if (stats != NULL) stats->misses_before = mesh_cache_line_misses(indices, num_indices, vertex_size);
+
+  mesh_optimize_triangle_order(indices, num_indices, num_vertices);
+  mesh_optimize_vertex_order(vertices, num_vertices, vertex_size, indices, num_indices);
+
+  if (stats != NULL) stats->misses_after = mesh_cache_line_misses(indices, num_indices, vertex_size);
+}
+
+// Greedily emits the triangle with the highest score, where a triangle's score is the sum of its vertices' scores.
+// Vertices score higher the more recently they were used (they are likely still cached), and the fewer triangles they
+// have left (so that they can be retired from the cache for good).
+void mesh_optimize_triangle_order(size_t indices[], size_t num_indices, size_t num_vertices)
+{
+  const size_t num_triangles = num_indices / 3;
+  if (num_triangles == 0) return;
+
+  // Triangles using each vertex. The triangles still to be emitted are kept at the front of each vertex's range.
+  size_t* offsets = calloc(num_vertices + 1, sizeof(size_t));
+  for (size_t i = 0; i < num_indices; i++) {
+    offsets[indices[i] + 1]++;
+  }
+  for (size_t i = 0; i < num_vertices; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+
+  size_t* adjacency = malloc(num_indices * sizeof(size_t));
+  size_t* remaining = calloc(num_vertices, sizeof(size_t));
+  for (size_t i = 0; i < num_indices; i++) {
+    const size_t v = indices[i];
+    adjacency[offsets[v] + remaining[v]++] = i / 3;
+  }
+
+  int* cache_positions = malloc(num_vertices * sizeof(int));
+  float* vertex_scores = malloc(num_vertices * sizeof(float));
+  for (size_t i = 0; i < num_vertices; i++) {
+    cache_positions[i] = -1;
+    vertex_scores[i] = vertex_score(-1, remaining[i]);
+  }
+
+  float* triangle_scores = malloc(num_triangles * sizeof(float));
+  bool* emitted = calloc(num_triangles, sizeof(bool));
+  size_t best_triangle = 0;
+  for (size_t i = 0; i < num_triangles; i++) {
+    triangle_scores[i] = vertex_scores[indices[3 * i]] + vertex_scores[indices[3 * i + 1]] +
+                         vertex_scores[indices[3 * i + 2]];
+    if (triangle_scores[i] > triangle_scores[best_triangle]) best_triangle = i;
+  }
+
+  size_t* output = malloc(num_indices * sizeof(size_t));
+  size_t cache[VERTEX_CACHE_SIZE + 3];
+  size_t cache_size = 0;
+  size_t next_unemitted = 0;
+
+  for (size_t n = 0; n < num_triangles; n++) {
+    // Nothing in the cache is used by a remaining triangle, so start over somewhere else.
+    if (best_triangle == NO_TRIANGLE) {
+      while (emitted[next_unemitted]) next_unemitted++;
+      best_triangle = next_unemitted;
+    }
+
+    const size_t* triangle = &indices[3 * best_triangle];
+    memcpy(&output[3 * n], triangle, 3 * sizeof(size_t));
+    emitted[best_triangle] = true;
+
+    for (size_t k = 0; k < 3; k++) {
+      const size_t v = triangle[k];
+      size_t* triangles = &adjacency[offsets[v]];
+      for (size_t j = 0; j < remaining[v]; j++) {
+        if (triangles[j] == best_triangle) {
+          triangles[j] = triangles[--remaining[v]];
+          break;
+        }
+      }
+    }
+
+    // The triangle's vertices move to the front of the cache, pushing the others back.
+    size_t new_cache[VERTEX_CACHE_SIZE + 3];
+    size_t new_cache_size = 0;
+    for (size_t k = 0; k < 3; k++) {
+      if ((k < 1 || triangle[k] != triangle[0]) && (k < 2 || triangle[k] != triangle[1])) {
+        new_cache[new_cache_size++] = triangle[k];
+      }
+    }
+    for (size_t i = 0; i < cache_size; i++) {
+      const size_t v = cache[i];
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2]) new_cache[new_cache_size++] = v;
+    }
+
+    // Rescore everything that moved, including the vertices that just fell out of the cache.
+    for (size_t i = 0; i < new_cache_size; i++) {
+      const size_t v = new_cache[i];
+      cache_positions[v] = i < VERTEX_CACHE_SIZE ? (int)i : -1;
+      vertex_scores[v] = vertex_score(cache_positions[v], remaining[v]);
+    }
+
+    best_triangle = NO_TRIANGLE;
+    float best_score = -1.0f;
+    for (size_t i = 0; i < new_cache_size; i++) {
+      const size_t v = new_cache[i];
+      for (size_t j = 0; j < remaining[v]; j++) {
+        const size_t t = adjacency[offsets[v] + j];
+        const size_t* tv = &indices[3 * t];
+        triangle_scores[t] = vertex_scores[tv[0]] + vertex_scores[tv[1]] + vertex_scores[tv[2]];
+        if (triangle_scores[t] > best_score) {
+          best_score = triangle_scores[t];
+          best_triangle = t;
+        }
+      }
+    }
+
+    cache_size = new_cache_size < VERTEX_CACHE_SIZE ? new_cache_size : VERTEX_CACHE_SIZE;
+    memcpy(cache, new_cache, cache_size * sizeof(size_t));
+  }
+
+  memcpy(indices, output, num_indices * sizeof(size_t));
+
+  free(offsets);
+  free(adjacency);
+  free(remaining);
+  free(cache_positions);
+  free(vertex_scores);
+  free(triangle_scores);
+  free(emitted);
+  free(output);
+}
+
+// Renumbers vertices in the order the indices first reference them. Unreferenced vertices are moved to the end.
+void mesh_optimize_vertex_order(void* vertices,
+                                size_t num_vertices,
+                                size_t vertex_size,
+                                size_t indices[],
+                                size_t num_indices)
+{
+  size_t* remap = malloc(num_vertices * sizeof(size_t));
+  for (size_t i = 0; i < num_vertices; i++) {
+    remap[i] = SIZE_MAX;
+  }
+
+  size_t next_vertex = 0;
+  for (size_t i = 0; i < num_indices; i++) {
+    if (remap[indices[i]] == SIZE_MAX) remap[indices[i]] = next_vertex++;
+    indices[i] = remap[indices[i]];
+  }
+  for (size_t i = 0; i < num_vertices; i++) {
+    if (remap[i] == SIZE_MAX) remap[i] = next_vertex++;
+  }
+
+  unsigned char* source = vertices;
+  unsigned char* reordered = malloc(num_vertices * vertex_size);
+  for (size_t i = 0; i < num_vertices; i++) {
+    memcpy(&reordered[remap[i] * vertex_size], &source[i * vertex_size], vertex_size);
+  }
+  memcpy(vertices, reordered, num_vertices * vertex_size);
+
+  free(reordered);
+  free(remap);
+}
+
+// Average number of cache lines that have to be fetched per triangle when reading the vertices it references.
+double mesh_cache_line_misses(const size_t indices[], size_t num_indices, size_t vertex_size)
+{
+  if (num_indices < 3) return 0.0;
+
+  uint64_t tags[CACHE_NUM_SETS][CACHE_NUM_WAYS];
+  uint64_t last_used[CACHE_NUM_SETS][CACHE_NUM_WAYS];
+  memset(tags, 0xff, sizeof(tags));
+  memset(last_used, 0, sizeof(last_used));
+
+  uint64_t time = 0;
+  size_t misses = 0;
+
+  for (size_t i = 0; i < num_indices; i++) {
+    const size_t first_line = indices[i] * vertex_size / CACHE_LINE_SIZE;
+    const size_t last_line = ((indices[i] + 1) * vertex_size - 1) / CACHE_LINE_SIZE;
+
+    for (size_t line = first_line; line <= last_line; line++) {
+      const size_t set = line % CACHE_NUM_SETS;
+      time++;
+
+      size_t victim = 0;
+      bool hit = false;
+      for (size_t way = 0; way < CACHE_NUM_WAYS; way++) {
+        if (tags[set][way] == line) {
+          last_used[set][way] = time;
+          hit = true;
+          break;
+        }
+        if (last_used[set][way] < last_used[set][victim]) victim = way;
+      }
+
+      if (!hit) {
+        tags[set][victim] = line;
+        last_used[set][victim] = time;
+        misses++;
+      }
+    }
+  }
+
+  return (double)misses / (num_indices / 3);
+}
+
+static float vertex_score(int cache_position, size_t remaining_triangles)
+{
+  if (remaining_triangles == 0) return -1.0f;
+
+  float score = 0.0f;
+  if (cache_position >= 0) {
+    if (cache_position < 3) {
+      score = LAST_TRIANGLE_SCORE;
+    } else {
+      const float scale = 1.0f / (VERTEX_CACHE_SIZE - 3);
+      score = pow(1.0f - (cache_position - 3) * scale, CACHE_DECAY_POWER);
+    }
+  }
+
+  return score + VALENCE_BOOST_SCALE * pow((float)remaining_triangles, -VALENCE_BOOST_POWER);
+}
@@ -0,0 +1,29 @@
+#ifndef MESH_OPTIMIZER_H_
+#define MESH_OPTIMIZER_H_
+
+#include <stddef.h>
+
+typedef struct
+{
+  double misses_before;  // Average cache line misses per triangle
+  double misses_after;
+} MeshOptimizationStats;
+
+// Reorders triangles for vertex locality and then renumbers vertices in the order the triangles first use them, so
+// that consecutive triangles fetch mostly the same, and otherwise neighboring, vertices. `vertices` is an array of
+// `num_vertices` elements of `vertex_size` bytes. `stats` may be NULL.
+void mesh_optimize(void* vertices,
+                   size_t num_vertices,
+                   size_t vertex_size,
+                   size_t indices[],
+                   size_t num_indices,
+                   MeshOptimizationStats* stats);
+void mesh_optimize_triangle_order(size_t indices[], size_t num_indices, size_t num_vertices);
+void mesh_optimize_vertex_order(void* vertices,
+                                size_t num_vertices,
+                                size_t vertex_size,
+                                size_t indices[],
+                                size_t num_indices);
+double mesh_cache_line_misses(const size_t indices[], size_t num_indices, size_t vertex_size);
+
+#endif
@@ -0,0 +1,415 @@
+#include "mesh_simplifier.h"
+
+#include "hash_map.h"
+#include "vector.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <tgmath.h>
+
+// Area weighted sum of squared distances to a set of planes, as the symmetric 4x4 matrix of the quadratic form, along
+// with the total weight.
+typedef struct
+{
+  double xx, xy, xz, xw;
+  double yy, yz, yw;
+  double zz, zw;
+  double ww;
+  double weight;
+} Quadric;
+
+typedef enum {
+  VERTEX_KIND_MANIFOLD,  // The only vertex at its position, inside the mesh
+  VERTEX_KIND_SEAM,      // One of two vertices at the same position, which have to move together
+  VERTEX_KIND_LOCKED,    // On a border or where several seams meet, so it never moves
+} VertexKind;
+
+typedef struct
+{
+  size_t source;
+  size_t target;
+  double cost;
+} Collapse;
+
+typedef struct
+{
+  size_t a;
+  size_t b;
+} Edge;
+
+// The vertices and the current triangles, during one pass.
+typedef struct
+{
+  const unsigned char* positions;
+  size_t stride;
+  const size_t* indices;
+  const size_t* offsets;    // Triangles using each vertex are `adjacency[offsets[v]]` to `adjacency[offsets[v + 1]]`
+  const size_t* adjacency;
+  const size_t* welded;     // First vertex with the same position
+} Simplification;
+
+static const Vec3* position_at(const unsigned char* positions, size_t stride, size_t vertex);
+static void quadric_add_plane(Quadric* q, const Vec3* p0, const Vec3* p1, const Vec3* p2);
+static void quadric_add(Quadric* q, const Quadric* r);
+static double quadric_error(const Quadric* q, const Vec3* p);
+static VertexKind* classify_vertices(const size_t indices[],
+                                     size_t num_indices,
+                                     const unsigned char* positions,
+                                     size_t stride,
+                                     size_t num_vertices,
+                                     size_t welded[],
+                                     size_t siblings[]);
+static size_t find_seam_target(const Simplification* simplification, size_t sibling, size_t target);
+static bool collapse_flips_triangle(const Simplification* simplification, size_t source, size_t target);
+static size_t collapse_mark_touched(const Simplification* simplification, size_t source, size_t target, bool touched[]);
+static uint64_t position_hash(const void* position);
+static bool positions_equal(const void* a, const void* b);
+static int edges_compare(const void* a, const void* b);
+static int collapses_compare(const void* a, const void* b);
+
+// Works in passes. Each pass sorts every edge by the cost of collapsing it, and then collapses the cheapest ones, as
+// long as they don't touch a triangle that another collapse in the same pass already changed. That keeps every cost
+// and flip check exact without having to maintain a priority queue. Quadrics are kept per position, so that both sides
+// of a seam see the same cost.
+size_t mesh_simplify(size_t output[],
+                     const size_t indices[],
+                     size_t num_indices,
+                     const unsigned char* positions,
+                     size_t stride,
+                     size_t num_vertices,
+                     size_t target_num_indices,
+                     float* error)
+{
+  memcpy(output, indices, num_indices * sizeof(size_t));
+
+  size_t* welded = malloc(num_vertices * sizeof(size_t));
+  size_t* siblings = malloc(num_vertices * sizeof(size_t));
+  VertexKind* kinds = classify_vertices(indices, num_indices, positions, stride, num_vertices, welded, siblings);
+
+  Quadric* quadrics = calloc(num_vertices, sizeof(Quadric));
+  for (size_t i = 0; i < num_indices; i += 3) {
+    const Vec3* p0 = position_at(positions, stride, indices[i]);
+    const Vec3* p1 = position_at(positions, stride, indices[i + 1]);
+    const Vec3* p2 = position_at(positions, stride, indices[i + 2]);
+    for (size_t k = 0; k < 3; k++) {
+      quadric_add_plane(&quadrics[welded[indices[i + k]]], p0, p1, p2);
+    }
+  }
+
+  size_t* offsets = malloc((num_vertices + 1) * sizeof(size_t));
+  size_t* adjacency = malloc(num_indices * sizeof(size_t));
+  Collapse* collapses = malloc(num_indices * sizeof(Collapse));
+  size_t* remap = malloc(num_vertices * sizeof(size_t));
+  bool* touched = malloc(num_vertices * sizeof(bool));
+  double max_cost = 0.0;
+
+  const Simplification simplification = {
+    .positions = positions,
+    .stride = stride,
+    .indices = output,
+    .offsets = offsets,
+    .adjacency = adjacency,
+    .welded = welded,
+  };
+
+  while (num_indices > target_num_indices) {
+    memset(offsets, 0, (num_vertices + 1) * sizeof(size_t));
+    for (size_t i = 0; i < num_indices; i++) {
+      offsets[output[i] + 1]++;
+    }
+    for (size_t i = 0; i < num_vertices; i++) {
+      offsets[i + 1] += offsets[i];
+    }
+    for (size_t i = 0; i < num_indices; i++) {
+      adjacency[offsets[output[i]]++] = i / 3;
+    }
+    for (size_t i = num_vertices; i > 0; i--) {
+      offsets[i] = offsets[i - 1];
+    }
+    offsets[0] = 0;
+
+    // The cheaper direction of every edge that can be collapsed at all.
+    size_t num_collapses = 0;
+    for (size_t i = 0; i < num_indices; i++) {
+      const size_t v0 = output[i];
+      const size_t v1 = output[i % 3 == 2 ? i - 2 : i + 1];
+      if (welded[v0] == welded[v1]) continue;
+
+      Quadric q = quadrics[welded[v0]];
+      quadric_add(&q, &quadrics[welded[v1]]);
+      const Vec3* p0 = position_at(positions, stride, v0);
+      const Vec3* p1 = position_at(positions, stride, v1);
+      const double cost0 = kinds[v0] == VERTEX_KIND_LOCKED ? INFINITY : quadric_error(&q, p1);
+      const double cost1 = kinds[v1] == VERTEX_KIND_LOCKED ? INFINITY : quadric_error(&q, p0);
+      if (cost0 == INFINITY && cost1 == INFINITY) continue;
+
+      collapses[num_collapses++] = cost0 <= cost1 ? (Collapse){ v0, v1, cost0 } : (Collapse){ v1, v0, cost1 };
+    }
+    qsort(collapses, num_collapses, sizeof(Collapse), collapses_compare);
+
+    for (size_t i = 0; i < num_vertices; i++) {
+      remap[i] = i;
+      touched[i] = false;
+    }
+
+    size_t num_removed = 0;
+    const size_t max_removed = (num_indices - target_num_indices + 2) / 3;
+    for (size_t c = 0; c < num_collapses && num_removed < max_removed; c++) {
+      const size_t source = collapses[c].source;
+      const size_t target = collapses[c].target;
+      if (touched[source] || touched[target]) continue;
+      if (collapse_flips_triangle(&simplification, source, target)) continue;
+
+      // A seam vertex takes its sibling along, onto the vertex next to the sibling at the target's position.
+      size_t sibling_target = SIZE_MAX;
+      if (kinds[source] == VERTEX_KIND_SEAM) {
+        sibling_target = find_seam_target(&simplification, siblings[source], target);
+        if (sibling_target == SIZE_MAX || touched[siblings[source]] || touched[sibling_target]) continue;
+        if (collapse_flips_triangle(&simplification, siblings[source], sibling_target)) continue;
+      }
+
+      remap[source] = target;
+      num_removed += collapse_mark_touched(&simplification, source, target, touched);
+      if (sibling_target != SIZE_MAX) {
+        remap[siblings[source]] = sibling_target;
+        num_removed += collapse_mark_touched(&simplification, siblings[source], sibling_target, touched);
+      }
+
+      quadric_add(&quadrics[welded[target]], &quadrics[welded[source]]);
+      if (collapses[c].cost > max_cost) max_cost = collapses[c].cost;
+    }
+
+    if (num_removed == 0) break;
+
+    size_t num_kept = 0;
+    for (size_t i = 0; i < num_indices; i += 3) {
+      const size_t v0 = remap[output[i]];
+      const size_t v1 = remap[output[i + 1]];
+      const size_t v2 = remap[output[i + 2]];
+      if (v0 == v1 || v1 == v2 || v2 == v0) continue;
+
+      output[num_kept++] = v0;
+      output[num_kept++] = v1;
+      output[num_kept++] = v2;
+    }
+    num_indices = num_kept;
+  }
+
+  if (error != NULL) *error = sqrt(max_cost);
+
+  free(welded);
+  free(siblings);
+  free(kinds);
+  free(quadrics);
+  free(offsets);
+  free(adjacency);
+  free(collapses);
+  free(remap);
+  free(touched);
+  return num_indices;
+}
+
+static const Vec3* position_at(const unsigned char* positions, size_t stride, size_t vertex)
+{
+  return (const Vec3*)&positions[vertex * stride];
+}
+
+static void quadric_add_plane(Quadric* q, const Vec3* p0, const Vec3* p1, const Vec3* p2)
+{
+  const Vec3 u = vec3_sub(p1, p0);
+  const Vec3 v = vec3_sub(p2, p0);
+  const Vec3 n = vec3_cross(&u, &v);
+  const double length = vec3_length(&n);
+  if (length == 0.0) return;
+
+  const double a = n.x / length;
+  const double b = n.y / length;
+  const double c = n.z / length;
+  const double d = -(a * p0->x + b * p0->y + c * p0->z);
+  const double weight = length / 2.0;
+
+  q->xx += weight * a * a;
+  q->xy += weight * a * b;
+  q->xz += weight * a * c;
+  q->xw += weight * a * d;
+  q->yy += weight * b * b;
+  q->yz += weight * b * c;
+  q->yw += weight * b * d;
+  q->zz += weight * c * c;
+  q->zw += weight * c * d;
+  q->ww += weight * d * d;
+  q->weight += weight;
+}
+
+static void quadric_add(Quadric* q, const Quadric* r)
+{
+  q->xx += r->xx;
+  q->xy += r->xy;
+  q->xz += r->xz;
+  q->xw += r->xw;
+  q->yy += r->yy;
+  q->yz += r->yz;
+  q->yw += r->yw;
+  q->zz += r->zz;
+  q->zw += r->zw;
+  q->ww += r->ww;
+  q->weight += r->weight;
+}
+
+// The weighted mean of the squared distances, so that its square root is a distance.
+static double quadric_error(const Quadric* q, const Vec3* p)
+{
+  if (q->weight == 0.0) return 0.0;
+
+  const double x = p->x;
+  const double y = p->y;
+  const double z = p->z;
+
+  const double error = q->xx * x * x + q->yy * y * y + q->zz * z * z + q->ww +
+                       2.0 * (q->xy * x * y + q->xz * x * z + q->yz * y * z + q->xw * x + q->yw * y + q->zw * z);
+  return error > 0.0 ? error / q->weight : 0.0;
+}
+
+// Vertices are welded by position to find the actual topology, since attribute seams split it. A position used by a
+// single vertex is manifold, one used by two is a seam, and anything else is locked. So are the positions on an edge
+// that doesn't have exactly two triangles, i.e. on a border or where the mesh isn't manifold.
+static VertexKind* classify_vertices(const size_t indices[],
+                                     size_t num_indices,
+                                     const unsigned char* positions,
+                                     size_t stride,
+                                     size_t num_vertices,
+                                     size_t welded[],
+                                     size_t siblings[])
+{
+  size_t* counts = calloc(num_vertices, sizeof(size_t));
+  HashMap first_vertices = hash_map_make(sizeof(Vec3), position_hash, positions_equal);
+  for (size_t i = 0; i < num_vertices; i++) {
+    if (hash_map_find(&first_vertices, position_at(positions, stride, i), &welded[i])) {
+      siblings[i] = welded[i];
+      siblings[welded[i]] = i;
+    } else {
+      hash_map_insert(&first_vertices, position_at(positions, stride, i), i);
+      welded[i] = i;
+    }
+    counts[welded[i]]++;
+  }
+  hash_map_destroy(&first_vertices);
+
+  bool* locked = calloc(num_vertices, sizeof(bool));
+  Edge* edges = malloc(num_indices * sizeof(Edge));
+  for (size_t i = 0; i < num_indices; i++) {
+    const size_t a = welded[indices[i]];
+    const size_t b = welded[indices[i % 3 == 2 ? i - 2 : i + 1]];
+    edges[i] = a < b ? (Edge){ a, b } : (Edge){ b, a };
+  }
+  qsort(edges, num_indices, sizeof(Edge), edges_compare);
+
+  for (size_t i = 0; i < num_indices;) {
+    size_t count = 1;
+    while (i + count < num_indices && edges_compare(&edges[i], &edges[i + count]) == 0) count++;
+    if (count != 2) locked[edges[i].a] = locked[edges[i].b] = true;
+    i += count;
+  }
+
+  VertexKind* kinds = malloc(num_vertices * sizeof(VertexKind));
+  for (size_t i = 0; i < num_vertices; i++) {
+    if (locked[welded[i]] || counts[welded[i]] > 2) {
+      kinds[i] = VERTEX_KIND_LOCKED;
+    } else {
+      kinds[i] = counts[welded[i]] == 2 ? VERTEX_KIND_SEAM : VERTEX_KIND_MANIFOLD;
+    }
+  }
+
+  free(counts);
+  free(locked);
+  free(edges);
+  return kinds;
+}
+
+// The vertex at the target's position that shares a triangle with `sibling`, if the collapse runs along the seam.
+static size_t find_seam_target(const Simplification* simplification, size_t sibling, size_t target)
+{
+  const size_t position = simplification->welded[target];
+  for (size_t j = simplification->offsets[sibling]; j < simplification->offsets[sibling + 1]; j++) {
+    const size_t* triangle = &simplification->indices[3 * simplification->adjacency[j]];
+    for (size_t k = 0; k < 3; k++) {
+      if (simplification->welded[triangle[k]] == position) return triangle[k];
+    }
+  }
+  return SIZE_MAX;
+}
+
+// Moving the source onto the target must not turn any of the source's other triangles over.
+static bool collapse_flips_triangle(const Simplification* simplification, size_t source, size_t target)
+{
+  const unsigned char* positions = simplification->positions;
+  const size_t stride = simplification->stride;
+
+  for (size_t j = simplification->offsets[source]; j < simplification->offsets[source + 1]; j++) {
+    const size_t* triangle = &simplification->indices[3 * simplification->adjacency[j]];
+    if (triangle[0] == target || triangle[1] == target || triangle[2] == target) continue;
+
+    const Vec3* before[3];
+    const Vec3* after[3];
+    for (size_t k = 0; k < 3; k++) {
+      before[k] = position_at(positions, stride, triangle[k]);
+      after[k] = triangle[k] == source ? position_at(positions, stride, target) : before[k];
+    }
+
+    const Vec3 u0 = vec3_sub(before[1], before[0]);
+    const Vec3 v0 = vec3_sub(before[2], before[0]);
+    const Vec3 n0 = vec3_cross(&u0, &v0);
+    const Vec3 u1 = vec3_sub(after[1], after[0]);
+    const Vec3 v1 = vec3_sub(after[2], after[0]);
+    const Vec3 n1 = vec3_cross(&u1, &v1);
+    if (vec3_dot(&n0, &n1) <= 0.0f) return true;
+  }
+  return false;
+}
+
+// Marks every vertex of the source's triangles, so that no other collapse in this pass changes them. Returns the number
+// of triangles that the collapse removes.
+static size_t collapse_mark_touched(const Simplification* simplification, size_t source, size_t target, bool touched[])
+{
+  size_t num_removed = 0;
+  for (size_t j = simplification->offsets[source]; j < simplification->offsets[source + 1]; j++) {
+    const size_t* triangle = &simplification->indices[3 * simplification->adjacency[j]];
+    num_removed += triangle[0] == target || triangle[1] == target || triangle[2] == target;
+    for (size_t k = 0; k < 3; k++) {
+      touched[triangle[k]] = true;
+    }
+  }
+  return num_removed;
+}
+
+static uint64_t position_hash(const void* position)
+{
+  const uint32_t* bits = position;
+  return hash_mix(((uint64_t)bits[0] << 32 | bits[1]) ^ hash_mix(bits[2]));
+}
+
+static bool positions_equal(const void* a, const void* b)
+{
+  const Vec3* p = a;
+  const Vec3* q = b;
+  return p->x == q->x && p->y == q->y && p->z == q->z;
+}
+
+static int edges_compare(const void* a, const void* b)
+{
+  const Edge* e = a;
+  const Edge* f = b;
+  if (e->a != f->a) return e->a < f->a ? -1 : 1;
+  if (e->b != f->b) return e->b < f->b ? -1 : 1;
+  return 0;
+}
+
+static int collapses_compare(const void* a, const void* b)
+{
+  const Collapse* c = a;
+  const Collapse* d = b;
+  if (c->cost != d->cost) return c->cost < d->cost ? -1 : 1;
+  return 0;
+}
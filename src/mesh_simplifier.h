@@ -0,0 +1,26 @@
+#ifndef MESH_SIMPLIFIER_H_
+#define MESH_SIMPLIFIER_H_
+
+#include <stddef.h>
+
+// Reduces the triangle count by collapsing edges in order of increasing quadric error (Garland and Heckbert), until at
+// most `target_num_indices` indices are left or no edge can be collapsed. Vertices are only ever collapsed onto other
+// existing vertices, so the result indexes into the same vertex array. `positions` points to the first vertex
+// position, and `stride` is the distance between consecutive ones.
+//
+// Vertices on a border never move, and two vertices sharing a position (a seam in some other attribute) only move
+// together along the seam, which keeps the mesh free of cracks. Positions shared by more vertices stay locked.
+//
+// Writes the remaining indices to `output`, which needs room for `num_indices`, and returns their number. If `error`
+// isn't NULL, it's set to the largest area weighted RMS distance, as measured by the quadrics, between the simplified
+// surface and the original one.
+size_t mesh_simplify(size_t output[],
+                     const size_t indices[],
+                     size_t num_indices,
+                     const unsigned char* positions,
+                     size_t stride,
+                     size_t num_vertices,
+                     size_t target_num_indices,
+                     float* error);
+
+#endif
@@ -0,0 +1,23 @@
+#include "mesh_source.h"
+
+#include "vector.h"
+
+#include <stddef.h>
+
+MeshSource mesh_source_make(void)
+{
+  return (MeshSource){
+    .positions = dyn_list_make(sizeof(Vec3)),
+    .normals = dyn_list_make(sizeof(Vec3)),
+    .uvs = dyn_list_make(sizeof(Vec2)),
+    .indices = dyn_list_make(sizeof(size_t)),
+  };
+}
+
+void mesh_source_destroy(MeshSource* source)
+{
+  dyn_list_destroy(&source->positions);
+  dyn_list_destroy(&source->normals);
+  dyn_list_destroy(&source->uvs);
+  dyn_list_destroy(&source->indices);
+}
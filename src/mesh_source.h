@@ -0,0 +1,19 @@
+#ifndef MESH_SOURCE_H_
+#define MESH_SOURCE_H_
+
+#include "dynlist.h"
+
+// Indexed triangles as read from a format that, unlike OBJ, stores one set of attributes per vertex. `normals` and
+// `uvs` are either empty or have one entry per position.
+typedef struct
+{
+  DynList positions;  // Vec3
+  DynList normals;    // Vec3
+  DynList uvs;        // Vec2
+  DynList indices;    // size_t, three per triangle
+} MeshSource;
+
+MeshSource mesh_source_make(void);
+void mesh_source_destroy(MeshSource* source);
+
+#endif
@@ -1,4 +1,2 @@
-#include "normal_mesh.h"
-
 #define MESH_IMPLEMENTATION
-#include "mesh.inc"
+#include "normal_mesh.h"
@@ -3,15 +3,24 @@
 
 #include "vector.h"
 
+#include <stdint.h>
+
 typedef struct
 {
   Vec3 pos;
   Vec3 normal;
 } NormalVertex;
 
+typedef struct
+{
+  uint16_t pos[3];    // See `PositionQuantization`
+  int16_t normal[2];  // Octahedral
+} PackedNormalVertex;
+
 #define MESH_TYPE_PREFIX        Normal
 #define MESH_FUNCTION_PREFIX    normal_
 #define MESH_VERTEX_TYPE        NormalVertex
+#define MESH_PACKED_VERTEX_TYPE PackedNormalVertex
 #define MESH_VERTEX_HAS_UVS     false
 #define MESH_VERTEX_HAS_NORMALS true
 
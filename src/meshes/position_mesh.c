@@ -1,4 +1,2 @@
-#include "position_mesh.h"
-
 #define MESH_IMPLEMENTATION
-#include "mesh.inc"
+#include "position_mesh.h"
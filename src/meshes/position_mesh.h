@@ -3,14 +3,22 @@
 
 #include "vector.h"
 
+#include <stdint.h>
+
 typedef struct
 {
   Vec3 pos;
 } PositionVertex;
 
+typedef struct
+{
+  uint16_t pos[3];  // See `PositionQuantization`
+} PackedPositionVertex;
+
 #define MESH_TYPE_PREFIX        Position
 #define MESH_FUNCTION_PREFIX    position_
 #define MESH_VERTEX_TYPE        PositionVertex
+#define MESH_PACKED_VERTEX_TYPE PackedPositionVertex
 #define MESH_VERTEX_HAS_UVS     false
 #define MESH_VERTEX_HAS_NORMALS false
 
@@ -1,4 +1,2 @@
-#include "texture_mesh.h"
-
 #define MESH_IMPLEMENTATION
-#include "mesh.inc"
+#include "texture_mesh.h"
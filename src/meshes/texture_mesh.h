@@ -3,15 +3,24 @@
 
 #include "vector.h"
 
+#include <stdint.h>
+
 typedef struct
 {
   Vec3 pos;
   Vec2 uv;
 } TextureVertex;
 
+typedef struct
+{
+  uint16_t pos[3];  // See `PositionQuantization`
+  uint16_t uv[2];   // Half floats
+} PackedTextureVertex;
+
 #define MESH_TYPE_PREFIX        Texture
 #define MESH_FUNCTION_PREFIX    texture_
 #define MESH_VERTEX_TYPE        TextureVertex
+#define MESH_PACKED_VERTEX_TYPE PackedTextureVertex
 #define MESH_VERTEX_HAS_UVS     true
 #define MESH_VERTEX_HAS_NORMALS false
 
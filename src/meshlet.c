@@ -0,0 +1,261 @@
+#include "meshlet.h"
+
+#include "index_buffer.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <tgmath.h>
+
+#define CONE_WEIGHT 1.0f
+#define NO_MESHLET  SIZE_MAX
+
+static Meshlet meshlet_make(const unsigned char* positions,
+                            size_t stride,
+                            const DynList* indices,
+                            size_t first_triangle,
+                            size_t num_triangles);
+static Vec3 triangle_unit_normal(const unsigned char* positions, size_t stride, const size_t vertices[3]);
+
+// Groups the triangles into meshlets of at most `MESHLET_MAX_VERTICES` distinct vertices and `MESHLET_MAX_TRIANGLES`
+// triangles, and reorders them so that each meshlet is a contiguous run of the index buffer. `positions` points to the
+// first vertex position, and `stride` is the distance between consecutive ones.
+//
+// Each meshlet grows from a seed triangle by repeatedly adding the neighboring triangle that brings in the fewest new
+// vertices, with a penalty for normals that stray from the meshlet's average so that its normal cone stays narrow.
+DynList meshlets_build(const unsigned char* positions, size_t stride, DynList* indices, size_t num_vertices)
+{
+  DynList meshlets = dyn_list_make(sizeof(Meshlet));
+
+  const size_t num_indices = indices->size;
+  const size_t num_triangles = num_indices / 3;
+  if (num_triangles == 0) return meshlets;
+
+  size_t* input = index_buffer_expand(indices);
+
+  // Triangles using each vertex. The triangles not yet in a meshlet are kept at the front of each vertex's range.
+  size_t* offsets = calloc(num_vertices + 1, sizeof(size_t));
+  for (size_t i = 0; i < num_indices; i++) {
+    offsets[input[i] + 1]++;
+  }
+  for (size_t i = 0; i < num_vertices; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+
+  size_t* adjacency = malloc(num_indices * sizeof(size_t));
+  size_t* remaining = calloc(num_vertices, sizeof(size_t));
+  for (size_t i = 0; i < num_indices; i++) {
+    const size_t v = input[i];
+    adjacency[offsets[v] + remaining[v]++] = i / 3;
+  }
+
+  Vec3* normals = malloc(num_triangles * sizeof(Vec3));
+  for (size_t t = 0; t < num_triangles; t++) {
+    normals[t] = triangle_unit_normal(positions, stride, &input[3 * t]);
+  }
+
+  size_t* vertex_meshlets = malloc(num_vertices * sizeof(size_t));
+  for (size_t i = 0; i < num_vertices; i++) {
+    vertex_meshlets[i] = NO_MESHLET;
+  }
+
+  bool* emitted = calloc(num_triangles, sizeof(bool));
+  size_t next_unemitted = 0;
+  size_t num_emitted = 0;
+  size_t seed = NO_MESHLET;
+
+  while (num_emitted < num_triangles) {
+    const size_t id = meshlets.size;
+    const size_t first_triangle = num_emitted;
+    size_t vertices[MESHLET_MAX_VERTICES];
+    size_t meshlet_num_vertices = 0;
+    Vec3 normal_sum = vec3_make(0.0f, 0.0f, 0.0f);
+
+    if (seed == NO_MESHLET) {
+      while (emitted[next_unemitted]) next_unemitted++;
+      seed = next_unemitted;
+    }
+    size_t triangle = seed;
+
+    while (triangle != NO_MESHLET) {
+      emitted[triangle] = true;
+      for (size_t k = 0; k < 3; k++) {
+        const size_t v = input[3 * triangle + k];
+        index_buffer_set(indices, 3 * num_emitted + k, v);
+
+        if (vertex_meshlets[v] != id) {
+          vertex_meshlets[v] = id;
+          vertices[meshlet_num_vertices++] = v;
+        }
+
+        // Drops the triangle from the vertex's remaining ones.
+        size_t* begin = &adjacency[offsets[v]];
+        for (size_t i = 0; i < remaining[v]; i++) {
+          if (begin[i] != triangle) continue;
+          begin[i] = begin[remaining[v] - 1];
+          begin[remaining[v] - 1] = triangle;
+          break;
+        }
+        remaining[v]--;
+      }
+      normal_sum = vec3_add(&normal_sum, &normals[triangle]);
+      num_emitted++;
+
+      if (num_emitted - first_triangle == MESHLET_MAX_TRIANGLES) break;
+
+      const float normal_sum_length = vec3_length(&normal_sum);
+      const Vec3 axis = normal_sum_length > 0.0f ? vec3_mul(&normal_sum, 1.0f / normal_sum_length) : normal_sum;
+
+      triangle = NO_MESHLET;
+      float best_cost = INFINITY;
+      for (size_t i = 0; i < meshlet_num_vertices; i++) {
+        const size_t v = vertices[i];
+        for (size_t j = offsets[v]; j < offsets[v] + remaining[v]; j++) {
+          const size_t candidate = adjacency[j];
+
+          size_t new_vertices = 0;
+          for (size_t k = 0; k < 3; k++) {
+            new_vertices += vertex_meshlets[input[3 * candidate + k]] != id;
+          }
+          if (meshlet_num_vertices + new_vertices > MESHLET_MAX_VERTICES) continue;
+
+          const float cost = new_vertices + CONE_WEIGHT * (1.0f - vec3_dot(&normals[candidate], &axis));
+          if (cost < best_cost) {
+            best_cost = cost;
+            triangle = candidate;
+          }
+        }
+      }
+    }
+
+    const Meshlet meshlet = meshlet_make(positions, stride, indices, first_triangle, num_emitted - first_triangle);
+    dyn_list_add(&meshlets, &meshlet);
+
+    // The next meshlet starts next to this one, at the triangle with the fewest neighbors left, so that the meshlets
+    // don't leave behind small islands of triangles.
+    seed = NO_MESHLET;
+    size_t best_live = SIZE_MAX;
+    for (size_t i = 0; i < meshlet_num_vertices; i++) {
+      const size_t v = vertices[i];
+      for (size_t j = offsets[v]; j < offsets[v] + remaining[v]; j++) {
+        const size_t candidate = adjacency[j];
+        size_t live = 0;
+        for (size_t k = 0; k < 3; k++) {
+          live += remaining[input[3 * candidate + k]];
+        }
+        if (live < best_live) {
+          best_live = live;
+          seed = candidate;
+        }
+      }
+    }
+  }
+
+  free(input);
+  free(offsets);
+  free(adjacency);
+  free(remaining);
+  free(normals);
+  free(vertex_meshlets);
+  free(emitted);
+  return meshlets;
+}
+
+// `camera_pos` is in the same (object) space as the meshlet. A triangle is backfacing when its normal points away from
+// the camera, i.e. dot(n, p - camera_pos) > 0 for any point p on it. With v = center - camera_pos, phi the angle
+// between v and the cone axis and theta the cone's half angle, every normal is within phi + theta of v, so the whole
+// meshlet is backfacing if |v| cos(phi + theta) > radius.
+bool meshlet_visible(const Meshlet* meshlet, const Frustum* frustum, const Vec3* camera_pos, CullMode cull_mode)
+{
+  if (!frustum_sphere_visible(frustum, &meshlet->center, meshlet->radius)) return false;
+  if (cull_mode == CULL_NONE) return true;
+
+  // Front faces are culled like back faces of the opposite cone.
+  const Vec3 v = vec3_sub(&meshlet->center, camera_pos);
+  const float v_dot_axis = vec3_dot(&v, &meshlet->cone_axis) * (cull_mode == CULL_FRONT ? -1.0f : 1.0f);
+  const float v_length_sq = vec3_dot(&v, &v);
+  const float v_cross_axis = sqrt(fmax(v_length_sq - v_dot_axis * v_dot_axis, 0.0f));
+
+  return v_dot_axis * meshlet->cone_cos - v_cross_axis * meshlet->cone_sin <= meshlet->radius;
+}
+
+static Meshlet meshlet_make(const unsigned char* positions,
+                            size_t stride,
+                            const DynList* indices,
+                            size_t first_triangle,
+                            size_t num_triangles)
+{
+  Meshlet meshlet = {
+    .first_triangle = first_triangle,
+    .num_triangles = num_triangles,
+    .first_index = 3 * first_triangle,
+    .num_indices = 3 * num_triangles,
+  };
+
+  // The sphere is centered on the bounding box, which is good enough for the small, compact patches meshlets are.
+  Vec3 min = *(const Vec3*)&positions[index_buffer_at(indices, 3 * first_triangle) * stride];
+  Vec3 max = min;
+  for (size_t i = 3 * first_triangle; i < 3 * (first_triangle + num_triangles); i++) {
+    const Vec3* p = (const Vec3*)&positions[index_buffer_at(indices, i) * stride];
+    min = vec3_make(fmin(min.x, p->x), fmin(min.y, p->y), fmin(min.z, p->z));
+    max = vec3_make(fmax(max.x, p->x), fmax(max.y, p->y), fmax(max.z, p->z));
+  }
+  meshlet.center = vec3_make((min.x + max.x) / 2.0f, (min.y + max.y) / 2.0f, (min.z + max.z) / 2.0f);
+
+  float radius_sq = 0.0f;
+  for (size_t i = 3 * first_triangle; i < 3 * (first_triangle + num_triangles); i++) {
+    const Vec3* p = (const Vec3*)&positions[index_buffer_at(indices, i) * stride];
+    const Vec3 d = vec3_sub(p, &meshlet.center);
+    radius_sq = fmax(radius_sq, vec3_dot(&d, &d));
+  }
+  meshlet.radius = sqrt(radius_sq);
+
+  // The cone axis is the average of the triangle normals, and the cone just wide enough to contain all of them.
+  Vec3 normals[MESHLET_MAX_TRIANGLES];
+  Vec3 axis = vec3_make(0.0f, 0.0f, 0.0f);
+  for (size_t t = 0; t < num_triangles; t++) {
+    const size_t i = 3 * (first_triangle + t);
+    const size_t vertices[3] = {
+      index_buffer_at(indices, i),
+      index_buffer_at(indices, i + 1),
+      index_buffer_at(indices, i + 2),
+    };
+    normals[t] = triangle_unit_normal(positions, stride, vertices);
+    axis = vec3_add(&axis, &normals[t]);
+  }
+
+  meshlet.cone_axis = vec3_make(0.0f, 0.0f, 0.0f);
+  meshlet.cone_cos = 0.0f;
+  meshlet.cone_sin = 1.0f;
+
+  const float axis_length = vec3_length(&axis);
+  if (axis_length == 0.0f) return meshlet;
+  axis = vec3_mul(&axis, 1.0f / axis_length);
+
+  float min_dot = 1.0f;
+  for (size_t t = 0; t < num_triangles; t++) {
+    if (normals[t].x == 0.0f && normals[t].y == 0.0f && normals[t].z == 0.0f) continue;
+    min_dot = fmin(min_dot, vec3_dot(&normals[t], &axis));
+  }
+
+  // A cone of 90 degrees or more can't ever be entirely backfacing. Otherwise, the cone is widened slightly to account
+  // for rounding.
+  if (min_dot <= 0.01f) return meshlet;
+  meshlet.cone_axis = axis;
+  meshlet.cone_cos = min_dot - 0.01f;
+  meshlet.cone_sin = sqrt(1.0f - meshlet.cone_cos * meshlet.cone_cos);
+  return meshlet;
+}
+
+// Degenerate triangles are never drawn, so they get a zero normal, which doesn't constrain any cone.
+static Vec3 triangle_unit_normal(const unsigned char* positions, size_t stride, const size_t vertices[3])
+{
+  const Vec3* p0 = (const Vec3*)&positions[vertices[0] * stride];
+  const Vec3* p1 = (const Vec3*)&positions[vertices[1] * stride];
+  const Vec3* p2 = (const Vec3*)&positions[vertices[2] * stride];
+
+  const Vec3 u = vec3_sub(p1, p0);
+  const Vec3 w = vec3_sub(p2, p0);
+  const Vec3 n = vec3_cross(&u, &w);
+  const float length = vec3_length(&n);
+  return length > 0.0f ? vec3_mul(&n, 1.0f / length) : vec3_make(0.0f, 0.0f, 0.0f);
+}
@@ -0,0 +1,38 @@
+#ifndef MESHLET_H_
+#define MESHLET_H_
+
+#include "cull_mode.h"
+#include "dynlist.h"
+#include "frustum.h"
+#include "vector.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MESHLET_MAX_VERTICES  64
+#define MESHLET_MAX_TRIANGLES 124
+
+// A run of consecutive triangles in a mesh's index buffer, with bounds that allow culling all of them at once. Every
+// triangle's (unit) normal is within the cone around `cone_axis` whose half angle has the given cosine and sine. An
+// empty cone (cosine 0) disables backface culling of the meshlet.
+//
+// In a triangle list, the meshlet's indices are those of its triangles. Strips and fans are split so that each
+// meshlet's indices start a new one.
+typedef struct
+{
+  uint32_t first_triangle;
+  uint32_t num_triangles;
+  uint32_t first_index;
+  uint32_t num_indices;
+  Vec3 center;
+  float radius;
+  Vec3 cone_axis;
+  float cone_cos;
+  float cone_sin;
+} Meshlet;
+
+DynList meshlets_build(const unsigned char* positions, size_t stride, DynList* indices, size_t num_vertices);
+bool meshlet_visible(const Meshlet* meshlet, const Frustum* frustum, const Vec3* camera_pos, CullMode cull_mode);
+
+#endif
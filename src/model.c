@@ -1,13 +1,82 @@
 #include "model.h"
 
 #include "vector.h"
-#include "utility.h"
+#include "mapped_file.h"
+#include "parallel.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
 #include <assert.h>
 
+// Longest number that is handed to `strtof` when the fast float path can't be used.
+#define MAX_NUMBER_LENGTH 128
+
+// Files smaller than this are parsed on the calling thread.
+#define CHUNK_SIZE (4 * 1024 * 1024)
+
+// Smaller chunks for progressive loading, so that the first one is ready quickly.
+#define PROGRESS_CHUNK_SIZE (1024 * 1024)
+
+typedef enum {
+  INDEX_KIND_POSITION,
+  INDEX_KIND_UV,
+  INDEX_KIND_NORMAL,
+} IndexKind;
+
+// A negative face index. Since chunks don't know how many elements precede them, these are resolved once every chunk
+// has been parsed.
+typedef struct
+{
+  size_t face;
+  size_t line;          // Within the chunk
+  long offset;          // Chunk-local element count plus the index, may be negative
+  unsigned char element;
+  IndexKind kind;
+} RelativeIndex;
+
+typedef struct
+{
+  const char* start;
+  const char* end;
+  Model model;
+  DynList relative_indices;  // RelativeIndex
+  size_t num_lines;
+  const char* error;  // NULL if the chunk was parsed successfully
+  size_t error_line;
+} ModelChunk;
+
+typedef struct
+{
+  const char* ptr;
+  const char* end;
+} Scanner;
+
+static const char* chunk_end_after(const char* start, size_t size, const char* end);
+static void model_parse_chunk(void* context, size_t index);
+static const char* model_parse_line(ModelChunk* chunk, Scanner* line);
+static bool model_parse_face_element(ModelChunk* chunk, Scanner* scanner, size_t element_index, FaceElement* element);
+static bool model_parse_index(ModelChunk* chunk, Scanner* scanner, size_t element_index, IndexKind kind, size_t* index);
+static bool model_resolve_chunk(ModelChunk* chunk, const size_t base_counts[3], size_t line_base, const char* path);
+static bool model_append(Model* model, const Model* chunk_model, const char* path);
+
+static bool scan_prefix(Scanner* scanner, const char* prefix);
+static void skip_spaces(Scanner* scanner);
+static bool scan_float(Scanner* scanner, float* value);
+static bool scan_long(Scanner* scanner, long* value);
+
+static inline bool is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
 Model model_make(void)
 {
   return (Model){
@@ -26,107 +95,131 @@ void model_destroy(Model* model)
   dyn_list_destroy(&model->normals);
 }
 
+// The file is mapped into memory and tokenized in place, so there is no limit on line length and nothing gets copied
+// besides the parsed values. Large files are split into line-aligned chunks that are parsed in parallel and then
+// concatenated in order, which gives exactly the same result as parsing the whole file at once.
 bool model_load_from_file(Model* model, const char* path)
 {
-  FILE* input = fopen(path, "r");
-  if (input == NULL) {
+  MappedFile file = mapped_file_make();
+  if (!mapped_file_open(&file, path)) {
     fprintf(stderr, "Failed to open model file: %s\n", path);
     return false;
   }
 
-  char line[1024];
-  size_t line_number = 0;
+  const char* data = (const char*)file.data;
+  const char* end = data + file.size;
 
-  while (fgets(line, sizeof(line), input) != NULL) {
-    line_number++;
-
-    if (line[0] == '#') continue;  // Comment
+  size_t num_chunks = 1;
+  if (file.size > CHUNK_SIZE && parallel_num_threads() > 1) {
+    num_chunks = (file.size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  }
+  ModelChunk* chunks = malloc(num_chunks * sizeof(ModelChunk));
 
-    // Position
-    if (strncmp(line, "v ", 2) == 0) {
-      Vec3 pos;
-      if (sscanf(&line[2], "%f %f %f", &pos.x, &pos.y, &pos.z) != 3) {
-        fprintf(stderr, "Failed to read position: %s, line %zu\n", path, line_number);
-        return false;
-      }
-      dyn_list_add(&model->positions, &pos);
-      continue;
+  const char* chunk_start = data;
+  for (size_t i = 0; i < num_chunks; i++) {
+    const char* chunk_end = end;
+    if (i + 1 < num_chunks) {
+      const char* boundary = data + (i + 1) * CHUNK_SIZE;
+      chunk_end = chunk_end_after(chunk_start, boundary > chunk_start ? boundary - chunk_start : 0, end);
     }
 
-    // Texture coordinate
-    if (strncmp(line, "vt ", 3) == 0) {
-      Vec2 uv;
-      if (sscanf(&line[2], "%f %f", &uv.x, &uv.y) != 2) {
-        fprintf(stderr, "Failed to read texture coordinate: %s, line %zu\n", path, line_number);
-        return false;
-      }
-      dyn_list_add(&model->uvs, &uv);
-      continue;
-    }
+    chunks[i] = (ModelChunk){
+      .start = chunk_start,
+      .end = chunk_end,
+      .model = num_chunks == 1 ? *model : model_make(),
+      .relative_indices = dyn_list_make(sizeof(RelativeIndex)),
+    };
+    chunk_start = chunk_end;
+  }
 
-    // Normal
-    if (strncmp(line, "vn ", 3) == 0) {
-      Vec3 normal;
-      if (sscanf(&line[2], "%f %f %f", &normal.x, &normal.y, &normal.z) != 3) {
-        fprintf(stderr, "Failed to read normal: %s, line %zu\n", path, line_number);
-        return false;
-      }
-      dyn_list_add(&model->normals, &normal);
-      continue;
-    }
+  parallel_for(num_chunks, model_parse_chunk, chunks);
 
-    // Face
-    if (strncmp(line, "f ", 2) == 0) {
-      char elem_strs[3][sizeof(line)];
-      if (sscanf(&line[2], "%s %s %s", elem_strs[0], elem_strs[1], elem_strs[2]) != 3) {
-        fprintf(stderr, "Failed to read face elements: %s, line %zu\n", path, line_number);
-        return false;
-      }
+  // A single chunk parses straight into `model`, otherwise the chunks are appended to it.
+  size_t base_counts[3] = { 0, 0, 0 };
+  if (num_chunks > 1) {
+    base_counts[INDEX_KIND_POSITION] = model->positions.size;
+    base_counts[INDEX_KIND_UV] = model->uvs.size;
+    base_counts[INDEX_KIND_NORMAL] = model->normals.size;
+  }
+  size_t line_base = 0;
+  bool parsed = true;
 
-      Face face;
-
-      for (size_t i = 0; i < 3; i++) {
-        char* ptr = elem_strs[i];
-
-        // Read position index
-        const char* pos_index = strsep(&ptr, "/");
-        if (pos_index == NULL) {
-          fprintf(stderr, "Failed to read face position index: %s, line %zu\n", path, line_number);
-          return false;
-        }
-        sscanf(pos_index, "%zu", &face.elements[i].pos_index);
-        face.elements[i].pos_index--;  // Make zero-based
-
-        // Read (optional) texture coordinate index
-        const char* uv_index = strsep(&ptr, "/");
-        if (uv_index == NULL || uv_index[0] == '\0') {
-          face.elements[i].has_uv = false;
-          face.elements[i].uv_index = 0;
-        } else {
-          face.elements[i].has_uv = true;
-          sscanf(uv_index, "%zu", &face.elements[i].uv_index);
-          face.elements[i].uv_index--;  // Make zero-based
-        }
-
-        // Read (optional) normal index
-        const char* normal_index = strsep(&ptr, "/");
-        if (normal_index == NULL || normal_index[0] == '\0') {
-          face.elements[i].has_normal = false;
-          face.elements[i].normal_index = 0;
-        } else {
-          face.elements[i].has_normal = true;
-          sscanf(normal_index, "%zu", &face.elements[i].normal_index);
-          face.elements[i].normal_index--;  // Make zero-based
-        }
-      }
+  for (size_t i = 0; i < num_chunks && parsed; i++) {
+    ModelChunk* chunk = &chunks[i];
+    parsed = model_resolve_chunk(chunk, base_counts, line_base, path);
+
+    base_counts[INDEX_KIND_POSITION] += chunk->model.positions.size;
+    base_counts[INDEX_KIND_UV] += chunk->model.uvs.size;
+    base_counts[INDEX_KIND_NORMAL] += chunk->model.normals.size;
+    line_base += chunk->num_lines;
+  }
+
+  if (num_chunks == 1) {
+    *model = chunks[0].model;
+  } else {
+    dyn_list_reserve(&model->positions, base_counts[INDEX_KIND_POSITION]);
+    dyn_list_reserve(&model->uvs, base_counts[INDEX_KIND_UV]);
+    dyn_list_reserve(&model->normals, base_counts[INDEX_KIND_NORMAL]);
 
-      dyn_list_add(&model->faces, &face);
-      continue;
+    for (size_t i = 0; i < num_chunks; i++) {
+      Model* chunk_model = &chunks[i].model;
+      parsed = parsed && model_append(model, chunk_model, path);
+      model_destroy(chunk_model);
     }
   }
 
-  fclose(input);
-  return true;
+  for (size_t i = 0; i < num_chunks; i++) {
+    dyn_list_destroy(&chunks[i].relative_indices);
+  }
+  free(chunks);
+
+  mapped_file_close(&file);
+  return parsed;
+}
+
+// Parses the file one chunk at a time on the calling thread, so that `on_progress` can use the beginning of the model
+// while the rest is still being read. Positive face indices may refer to elements that a later chunk adds.
+bool model_load_progressively(Model* model, const char* path, ModelProgressCallback on_progress, void* context)
+{
+  MappedFile file = mapped_file_make();
+  if (!mapped_file_open(&file, path)) {
+    fprintf(stderr, "Failed to open model file: %s\n", path);
+    return false;
+  }
+
+  const char* data = (const char*)file.data;
+  const char* end = data + file.size;
+
+  size_t base_counts[3] = { model->positions.size, model->uvs.size, model->normals.size };
+  size_t line_base = 0;
+  bool parsed = true;
+
+  for (const char* chunk_start = data; chunk_start < end && parsed;) {
+    ModelChunk chunk = {
+      .start = chunk_start,
+      .end = chunk_end_after(chunk_start, PROGRESS_CHUNK_SIZE, end),
+      .model = model_make(),
+      .relative_indices = dyn_list_make(sizeof(RelativeIndex)),
+    };
+    model_parse_chunk(&chunk, 0);
+    parsed = model_resolve_chunk(&chunk, base_counts, line_base, path);
+
+    parsed = parsed && model_append(model, &chunk.model, path);
+
+    base_counts[INDEX_KIND_POSITION] += chunk.model.positions.size;
+    base_counts[INDEX_KIND_UV] += chunk.model.uvs.size;
+    base_counts[INDEX_KIND_NORMAL] += chunk.model.normals.size;
+    line_base += chunk.num_lines;
+    chunk_start = chunk.end;
+
+    model_destroy(&chunk.model);
+    dyn_list_destroy(&chunk.relative_indices);
+
+    if (parsed && !on_progress(context, model)) parsed = false;
+  }
+
+  mapped_file_close(&file);
+  return parsed;
 }
 
 const Face* model_get_face(const Model* model, size_t index)
@@ -152,3 +245,310 @@ const Vec3* model_get_normal(const Model* model, size_t index)
   assert(index < model->normals.size);
   return dyn_list_at(&model->normals, index);
 }
+
+// The end of the line that contains `start + size`, or `end`.
+static const char* chunk_end_after(const char* start, size_t size, const char* end)
+{
+  if ((size_t)(end - start) <= size) return end;
+
+  const char* newline = memchr(start + size, '\n', end - (start + size));
+  return newline != NULL ? newline + 1 : end;
+}
+
+// Parses lines until the end of the chunk or the first error.
+static void model_parse_chunk(void* context, size_t index)
+{
+  ModelChunk* chunk = &((ModelChunk*)context)[index];
+
+  const char* ptr = chunk->start;
+  while (ptr < chunk->end) {
+    chunk->num_lines++;
+
+    const char* line_end = memchr(ptr, '\n', chunk->end - ptr);
+    if (line_end == NULL) line_end = chunk->end;
+
+    Scanner line = { .ptr = ptr, .end = line_end };
+    chunk->error = model_parse_line(chunk, &line);
+    if (chunk->error != NULL) {
+      chunk->error_line = chunk->num_lines;
+      return;
+    }
+
+    ptr = line_end + 1;
+  }
+}
+
+// Returns an error message, or NULL if the line was parsed successfully.
+static const char* model_parse_line(ModelChunk* chunk, Scanner* line)
+{
+  Model* model = &chunk->model;
+
+  if (line->ptr == line->end || line->ptr[0] == '#') return NULL;  // Comment
+
+  // Position
+  if (scan_prefix(line, "v")) {
+    Vec3* pos = dyn_list_add_slot(&model->positions);
+    if (pos == NULL) return "Out of memory";
+    if (!scan_float(line, &pos->x) || !scan_float(line, &pos->y) || !scan_float(line, &pos->z)) {
+      return "Failed to read position";
+    }
+    return NULL;
+  }
+
+  // Texture coordinate
+  if (scan_prefix(line, "vt")) {
+    Vec2* uv = dyn_list_add_slot(&model->uvs);
+    if (uv == NULL) return "Out of memory";
+    if (!scan_float(line, &uv->x) || !scan_float(line, &uv->y)) {
+      return "Failed to read texture coordinate";
+    }
+    return NULL;
+  }
+
+  // Normal
+  if (scan_prefix(line, "vn")) {
+    Vec3* normal = dyn_list_add_slot(&model->normals);
+    if (normal == NULL) return "Out of memory";
+    if (!scan_float(line, &normal->x) || !scan_float(line, &normal->y) || !scan_float(line, &normal->z)) {
+      return "Failed to read normal";
+    }
+    return NULL;
+  }
+
+  // Face. Only the first three elements are read.
+  if (scan_prefix(line, "f")) {
+    Face face;
+    for (size_t i = 0; i < 3; i++) {
+      if (!model_parse_face_element(chunk, line, i, &face.elements[i])) {
+        return "Failed to read face elements";
+      }
+    }
+    if (dyn_list_add(&model->faces, &face) == NULL) return "Out of memory";
+    return NULL;
+  }
+
+  return NULL;
+}
+
+// Reads `pos[/[uv][/normal]]`.
+static bool model_parse_face_element(ModelChunk* chunk, Scanner* scanner, size_t element_index, FaceElement* element)
+{
+  if (!model_parse_index(chunk, scanner, element_index, INDEX_KIND_POSITION, &element->pos_index)) return false;
+
+  element->has_uv = false;
+  element->uv_index = 0;
+  element->has_normal = false;
+  element->normal_index = 0;
+
+  if (scanner->ptr == scanner->end || scanner->ptr[0] != '/') return true;
+  scanner->ptr++;
+
+  if (scanner->ptr < scanner->end && (is_digit(scanner->ptr[0]) || scanner->ptr[0] == '-')) {
+    if (!model_parse_index(chunk, scanner, element_index, INDEX_KIND_UV, &element->uv_index)) return false;
+    element->has_uv = true;
+  }
+
+  if (scanner->ptr == scanner->end || scanner->ptr[0] != '/') return true;
+  scanner->ptr++;
+
+  if (scanner->ptr < scanner->end && (is_digit(scanner->ptr[0]) || scanner->ptr[0] == '-')) {
+    if (!model_parse_index(chunk, scanner, element_index, INDEX_KIND_NORMAL, &element->normal_index)) return false;
+    element->has_normal = true;
+  }
+
+  return true;
+}
+
+// Turns a one-based OBJ index into a zero-based one. Negative indices are relative to the most recently read element
+// of that kind, so they are recorded and resolved by `model_resolve_chunk`.
+static bool model_parse_index(ModelChunk* chunk, Scanner* scanner, size_t element_index, IndexKind kind, size_t* index)
+{
+  long value;
+  if (!scan_long(scanner, &value) || value == 0) return false;
+
+  if (value > 0) {
+    *index = value - 1;
+    return true;
+  }
+
+  const DynList* lists[] = { &chunk->model.positions, &chunk->model.uvs, &chunk->model.normals };
+  const RelativeIndex relative = {
+    .face = chunk->model.faces.size,
+    .line = chunk->num_lines,
+    .offset = (long)lists[kind]->size + value,
+    .element = element_index,
+    .kind = kind,
+  };
+  dyn_list_add(&chunk->relative_indices, &relative);
+
+  *index = 0;
+  return true;
+}
+
+// Resolves the chunk's relative indices given the number of elements of each kind that precede it, and reports the
+// first error in the chunk, if any.
+static bool model_resolve_chunk(ModelChunk* chunk, const size_t base_counts[3], size_t line_base, const char* path)
+{
+  for (size_t i = 0; i < chunk->relative_indices.size; i++) {
+    const RelativeIndex* relative = dyn_list_at(&chunk->relative_indices, i);
+    if (chunk->error != NULL && relative->line >= chunk->error_line) break;
+
+    const long index = (long)base_counts[relative->kind] + relative->offset;
+    if (index < 0) {
+      fprintf(stderr, "Failed to read face elements: %s, line %zu\n", path, line_base + relative->line);
+      return false;
+    }
+
+    Face* face = dyn_list_mutable_at(&chunk->model.faces, relative->face);
+    FaceElement* element = &face->elements[relative->element];
+    switch (relative->kind) {
+      case INDEX_KIND_POSITION:
+        element->pos_index = index;
+        break;
+      case INDEX_KIND_UV:
+        element->uv_index = index;
+        break;
+      case INDEX_KIND_NORMAL:
+        element->normal_index = index;
+        break;
+    }
+  }
+
+  if (chunk->error != NULL) {
+    fprintf(stderr, "%s: %s, line %zu\n", chunk->error, path, line_base + chunk->error_line);
+    return false;
+  }
+
+  return true;
+}
+
+static bool model_append(Model* model, const Model* chunk_model, const char* path)
+{
+  const bool appended =
+    dyn_list_append(&model->faces, chunk_model->faces.buffer, chunk_model->faces.size) &&
+    dyn_list_append(&model->positions, chunk_model->positions.buffer, chunk_model->positions.size) &&
+    dyn_list_append(&model->uvs, chunk_model->uvs.buffer, chunk_model->uvs.size) &&
+    dyn_list_append(&model->normals, chunk_model->normals.buffer, chunk_model->normals.size);
+  if (!appended) fprintf(stderr, "Out of memory: %s\n", path);
+  return appended;
+}
+
+// Matches `prefix` followed by at least one space.
+static bool scan_prefix(Scanner* scanner, const char* prefix)
+{
+  const size_t length = strlen(prefix);
+  if ((size_t)(scanner->end - scanner->ptr) <= length) return false;
+  if (memcmp(scanner->ptr, prefix, length) != 0 || !is_space(scanner->ptr[length])) return false;
+  scanner->ptr += length;
+  return true;
+}
+
+static void skip_spaces(Scanner* scanner)
+{
+  while (scanner->ptr < scanner->end && is_space(scanner->ptr[0])) scanner->ptr++;
+}
+
+// Numbers with at most 7 significant digits and a small decimal exponent are exactly representable as a float
+// mantissa and power of ten, so a single float multiplication or division rounds them exactly like `strtof` would.
+// Anything else is handed to `strtof`.
+static bool scan_float(Scanner* scanner, float* value)
+{
+  static const float powers_of_ten[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+  skip_spaces(scanner);
+
+  const char* ptr = scanner->ptr;
+  const char* end = scanner->end;
+  const char* start = ptr;
+
+  bool negative = false;
+  if (ptr < end && (ptr[0] == '-' || ptr[0] == '+')) {
+    negative = ptr[0] == '-';
+    ptr++;
+  }
+
+  uint64_t mantissa = 0;
+  int num_digits = 0;  // Significant digits, i.e. not counting leading zeros
+  int exponent = 0;
+  bool any_digits = false;
+
+  while (ptr < end && is_digit(ptr[0])) {
+    if (mantissa != 0 || ptr[0] != '0') num_digits++;
+    if (num_digits <= 19) mantissa = 10 * mantissa + (ptr[0] - '0');
+    else exponent++;
+    any_digits = true;
+    ptr++;
+  }
+
+  if (ptr < end && ptr[0] == '.') {
+    ptr++;
+    while (ptr < end && is_digit(ptr[0])) {
+      if (mantissa != 0 || ptr[0] != '0') num_digits++;
+      if (num_digits <= 19) {
+        mantissa = 10 * mantissa + (ptr[0] - '0');
+        exponent--;
+      }
+      any_digits = true;
+      ptr++;
+    }
+  }
+
+  if (!any_digits) return false;
+
+  bool simple = true;
+  if (ptr < end && (ptr[0] == 'e' || ptr[0] == 'E')) {
+    simple = false;  // Rare enough in OBJ files that the slow path is fine
+    ptr++;
+    if (ptr < end && (ptr[0] == '-' || ptr[0] == '+')) ptr++;
+    while (ptr < end && is_digit(ptr[0])) ptr++;
+  }
+
+  if (simple && mantissa <= (1 << 24) && exponent >= -10 && exponent <= 10) {
+    float result = mantissa;
+    result = exponent < 0 ? result / powers_of_ten[-exponent] : result * powers_of_ten[exponent];
+    *value = negative ? -result : result;
+    scanner->ptr = ptr;
+    return true;
+  }
+
+  char buffer[MAX_NUMBER_LENGTH];
+  const size_t length = ptr - start;
+  if (length >= sizeof(buffer)) return false;
+  memcpy(buffer, start, length);
+  buffer[length] = '\0';
+
+  char* parsed_end;
+  *value = strtof(buffer, &parsed_end);
+  if (parsed_end == buffer) return false;
+
+  scanner->ptr = start + (parsed_end - buffer);
+  return true;
+}
+
+static bool scan_long(Scanner* scanner, long* value)
+{
+  skip_spaces(scanner);
+
+  const char* ptr = scanner->ptr;
+  const char* end = scanner->end;
+
+  bool negative = false;
+  if (ptr < end && ptr[0] == '-') {
+    negative = true;
+    ptr++;
+  }
+
+  if (ptr == end || !is_digit(ptr[0])) return false;
+
+  long result = 0;
+  while (ptr < end && is_digit(ptr[0])) {
+    const int digit = ptr[0] - '0';
+    if (result > (LONG_MAX - digit) / 10) return false;  // Overflow
+    result = 10 * result + digit;
+    ptr++;
+  }
+
+  *value = negative ? -result : result;
+  scanner->ptr = ptr;
+  return true;
+}
@@ -32,6 +32,12 @@ typedef struct
 Model model_make(void);
 void model_destroy(Model* model);
 bool model_load_from_file(Model* model, const char* path);
+
+// Called by `model_load_progressively` after every chunk, once `model` holds everything up to the end of it. Returning
+// false stops loading.
+typedef bool (*ModelProgressCallback)(void* context, const Model* model);
+
+bool model_load_progressively(Model* model, const char* path, ModelProgressCallback on_progress, void* context);
 const Face* model_get_face(const Model* model, size_t index);
 const Vec3* model_get_position(const Model* model, size_t index);
 const Vec2* model_get_uv(const Model* model, size_t index);
@@ -0,0 +1,201 @@
+#include "occlusion_buffer.h"
+
+#include "index_buffer.h"
+
+#include <stdlib.h>
+#include <tgmath.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+// Occluders that reach closer than this (in w) are skipped, and boxes that do are always visible.
+#define MIN_W 1e-4f
+
+static Vec3 occlusion_buffer_to_screen(const OcclusionBuffer* buffer, const Vec4* clip);
+static void occlusion_buffer_draw_triangle(OcclusionBuffer* buffer, const Vec3* v0, const Vec3* v1, const Vec3* v2);
+
+OcclusionBuffer occlusion_buffer_make(int width, int height)
+{
+  return (OcclusionBuffer){
+    .width = width,
+    .height = height,
+    .values = malloc(width * height * sizeof(float)),
+    .clip_positions = dyn_list_make(sizeof(Vec4)),
+  };
+}
+
+void occlusion_buffer_destroy(OcclusionBuffer* buffer)
+{
+  free(buffer->values);
+  dyn_list_destroy(&buffer->clip_positions);
+}
+
+// Nothing is hidden until occluders are drawn.
+void occlusion_buffer_clear(OcclusionBuffer* buffer)
+{
+  for (int i = 0; i < buffer->width * buffer->height; i++) {
+    buffer->values[i] = 0.0f;
+  }
+}
+
+// Draws a triangle list occluder. `positions` points to the first vertex position, and `stride` is the distance
+// between consecutive ones. Triangles are drawn whichever way they face.
+void occlusion_buffer_draw(OcclusionBuffer* buffer,
+                           const Mat4* proj_world,
+                           const unsigned char* positions,
+                           size_t stride,
+                           size_t num_vertices,
+                           const DynList* indices)
+{
+  buffer->clip_positions.size = 0;
+  dyn_list_reserve(&buffer->clip_positions, num_vertices);
+  for (size_t i = 0; i < num_vertices; i++) {
+    const Vec3* pos = (const Vec3*)&positions[i * stride];
+    const Vec4 v = vec4_make(pos->x, pos->y, pos->z, 1.0f);
+    const Vec4 clip = mat4_vec_mul(proj_world, &v);
+    dyn_list_add(&buffer->clip_positions, &clip);
+  }
+  const Vec4* clip = (const Vec4*)buffer->clip_positions.buffer;
+
+  for (size_t i = 0; i + 2 < indices->size; i += 3) {
+    const Vec4* c0 = &clip[index_buffer_at(indices, i)];
+    const Vec4* c1 = &clip[index_buffer_at(indices, i + 1)];
+    const Vec4* c2 = &clip[index_buffer_at(indices, i + 2)];
+
+    // Clipping them would only make them cover less.
+    if (c0->w < MIN_W || c1->w < MIN_W || c2->w < MIN_W) continue;
+
+    const Vec3 v0 = occlusion_buffer_to_screen(buffer, c0);
+    const Vec3 v1 = occlusion_buffer_to_screen(buffer, c1);
+    const Vec3 v2 = occlusion_buffer_to_screen(buffer, c2);
+    occlusion_buffer_draw_triangle(buffer, &v0, &v1, &v2);
+  }
+}
+
+// The box is hidden if every pixel its corners project onto holds an occluder closer than its nearest corner. Boxes
+// that project entirely outside the buffer count as visible, leaving them to frustum culling.
+bool occlusion_buffer_box_visible(const OcclusionBuffer* buffer,
+                                  const Mat4* proj_world,
+                                  const Vec3* bounds_min,
+                                  const Vec3* bounds_max)
+{
+  float min_x = INFINITY;
+  float min_y = INFINITY;
+  float max_x = -INFINITY;
+  float max_y = -INFINITY;
+  float nearest = 0.0f;
+
+  for (int i = 0; i < 8; i++) {
+    const Vec4 corner = vec4_make(i & 1 ? bounds_max->x : bounds_min->x,
+                                  i & 2 ? bounds_max->y : bounds_min->y,
+                                  i & 4 ? bounds_max->z : bounds_min->z,
+                                  1.0f);
+    const Vec4 clip = mat4_vec_mul(proj_world, &corner);
+    if (clip.w < MIN_W) return true;
+
+    const Vec3 screen = occlusion_buffer_to_screen(buffer, &clip);
+    min_x = fmin(min_x, screen.x);
+    min_y = fmin(min_y, screen.y);
+    max_x = fmax(max_x, screen.x);
+    max_y = fmax(max_y, screen.y);
+    nearest = fmax(nearest, screen.z);
+  }
+
+  const int x0 = fmax(floor(min_x), 0.0f);
+  const int y0 = fmax(floor(min_y), 0.0f);
+  const int x1 = fmin(ceil(max_x), (float)buffer->width);
+  const int y1 = fmin(ceil(max_y), (float)buffer->height);
+  if (x0 >= x1 || y0 >= y1) return true;
+
+  for (int y = y0; y < y1; y++) {
+    const float* row = &buffer->values[y * buffer->width];
+    int x = x0;
+#if defined(__SSE__)
+    const __m128 nearest4 = _mm_set1_ps(nearest);
+    for (; x + 4 <= x1; x += 4) {
+      if (_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(&row[x]), nearest4)) != 0) return true;
+    }
+#endif
+    for (; x < x1; x++) {
+      if (row[x] <= nearest) return true;
+    }
+  }
+  return false;
+}
+
+// Returns the pixel coordinates, with pixel (x, y) covering [x, x + 1) x [y, y + 1), and 1 / w.
+static Vec3 occlusion_buffer_to_screen(const OcclusionBuffer* buffer, const Vec4* clip)
+{
+  const float inv_w = 1.0f / clip->w;
+  return vec3_make((clip->x * inv_w + 1.0f) * 0.5f * buffer->width,
+                   (1.0f - clip->y * inv_w) * 0.5f * buffer->height,
+                   inv_w);
+}
+
+// Each edge function is positive inside the triangle, and is evaluated at pixel centers. Pixels are only covered if
+// they are entirely inside, so the edge functions are shifted by half their extent across a pixel. Since 1 / w is
+// linear in screen space, its minimum over a pixel is likewise its value at the center less half its extent.
+static void occlusion_buffer_draw_triangle(OcclusionBuffer* buffer, const Vec3* v0, const Vec3* v1, const Vec3* v2)
+{
+  const float area = (v1->x - v0->x) * (v2->y - v0->y) - (v2->x - v0->x) * (v1->y - v0->y);
+  if (area == 0.0f) return;
+
+  const Vec3* vertices[3] = { v0, v1, v2 };
+  const float sign = area > 0.0f ? 1.0f : -1.0f;
+  float a[3];
+  float b[3];
+  float c[3];
+  for (int i = 0; i < 3; i++) {
+    const Vec3* p = vertices[(i + 1) % 3];
+    const Vec3* q = vertices[(i + 2) % 3];
+    a[i] = sign * (p->y - q->y);
+    b[i] = sign * (q->x - p->x);
+    c[i] = sign * (p->x * q->y - q->x * p->y);
+  }
+
+  // Divided by the area, the edge functions are the barycentric coordinates.
+  const float inv_area = 1.0f / fabs(area);
+  const float z_a = (a[0] * v0->z + a[1] * v1->z + a[2] * v2->z) * inv_area;
+  const float z_b = (b[0] * v0->z + b[1] * v1->z + b[2] * v2->z) * inv_area;
+  const float z_c = (c[0] * v0->z + c[1] * v1->z + c[2] * v2->z) * inv_area - 0.5f * (fabs(z_a) + fabs(z_b));
+  for (int i = 0; i < 3; i++) {
+    c[i] -= 0.5f * (fabs(a[i]) + fabs(b[i]));
+  }
+
+  const int x0 = fmax(floor(fmin(fmin(v0->x, v1->x), v2->x)), 0.0f);
+  const int y0 = fmax(floor(fmin(fmin(v0->y, v1->y), v2->y)), 0.0f);
+  const int x1 = fmin(ceil(fmax(fmax(v0->x, v1->x), v2->x)), (float)buffer->width);
+  const int y1 = fmin(ceil(fmax(fmax(v0->y, v1->y), v2->y)), (float)buffer->height);
+
+  for (int y = y0; y < y1; y++) {
+    const float py = y + 0.5f;
+    float* row = &buffer->values[y * buffer->width];
+    int x = x0;
+#if defined(__SSE__)
+    const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    for (; x + 4 <= x1; x += 4) {
+      const __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+      __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), px), _mm_set1_ps(b[0] * py + c[0])), zero);
+      inside = _mm_and_ps(
+        inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), px), _mm_set1_ps(b[1] * py + c[1])), zero));
+      inside = _mm_and_ps(
+        inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), px), _mm_set1_ps(b[2] * py + c[2])), zero));
+      if (_mm_movemask_ps(inside) == 0) continue;
+
+      const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(z_a), px), _mm_set1_ps(z_b * py + z_c));
+      const __m128 old = _mm_loadu_ps(&row[x]);
+      _mm_storeu_ps(&row[x], _mm_or_ps(_mm_and_ps(inside, _mm_max_ps(old, z)), _mm_andnot_ps(inside, old)));
+    }
+#endif
+    for (; x < x1; x++) {
+      const float px = x + 0.5f;
+      if (a[0] * px + b[0] * py + c[0] < 0.0f || a[1] * px + b[1] * py + c[1] < 0.0f ||
+          a[2] * px + b[2] * py + c[2] < 0.0f) {
+        continue;
+      }
+      row[x] = fmax(row[x], z_a * px + z_b * py + z_c);
+    }
+  }
+}
@@ -0,0 +1,37 @@
+#ifndef OCCLUSION_BUFFER_H_
+#define OCCLUSION_BUFFER_H_
+
+#include "dynlist.h"
+#include "matrix.h"
+#include "vector.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// A small depth buffer for finding objects hidden behind occluders (walls, large props) before drawing them. It holds
+// 1 / w of the nearest occluder at each pixel, so larger is closer. Occluders only cover the pixels they cover
+// entirely, at their furthest depth within them, so that objects it reports as hidden really are behind them. Pixels
+// along the edges between an occluder's triangles are covered by neither, which leaves gaps in tessellated meshes.
+typedef struct
+{
+  int width;
+  int height;
+  float* values;
+  DynList clip_positions;  // Vec4, reused between occluders
+} OcclusionBuffer;
+
+OcclusionBuffer occlusion_buffer_make(int width, int height);
+void occlusion_buffer_destroy(OcclusionBuffer* buffer);
+void occlusion_buffer_clear(OcclusionBuffer* buffer);
+void occlusion_buffer_draw(OcclusionBuffer* buffer,
+                           const Mat4* proj_world,
+                           const unsigned char* positions,
+                           size_t stride,
+                           size_t num_vertices,
+                           const DynList* indices);
+bool occlusion_buffer_box_visible(const OcclusionBuffer* buffer,
+                                  const Mat4* proj_world,
+                                  const Vec3* bounds_min,
+                                  const Vec3* bounds_max);
+
+#endif
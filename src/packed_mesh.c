@@ -0,0 +1,70 @@
+#include "packed_mesh.h"
+
+#include "mesh_lod.h"
+
+static DynList pack_vertices(const DynList* vertices,
+                             const PositionQuantization* quantization,
+                             size_t packed_vertex_size,
+                             VertexPacker pack_vertex);
+
+PackedMesh packed_mesh_make(const DynList* vertices,
+                            const DynList* indices,
+                            PrimitiveTopology topology,
+                            const DynList* meshlets,
+                            const DynList* lods,
+                            const Vec3* bounds_min,
+                            const Vec3* bounds_max,
+                            const Vec3* bounds_center,
+                            float bounds_radius,
+                            size_t packed_vertex_size,
+                            VertexPacker pack_vertex)
+{
+  const PositionQuantization quantization = position_quantization_make(bounds_min, bounds_max);
+
+  // The levels only use vertices of the full mesh, so they fit in its bounds too.
+  DynList packed_lods = dyn_list_make(sizeof(MeshLod));
+  for (size_t i = 0; i < lods->size; i++) {
+    const MeshLod* lod = dyn_list_at(lods, i);
+    const MeshLod packed_lod = {
+      .vertices = pack_vertices(&lod->vertices, &quantization, packed_vertex_size, pack_vertex),
+      .indices = dyn_list_copy(&lod->indices),
+      .meshlets = dyn_list_copy(&lod->meshlets),
+      .error = lod->error,
+    };
+    dyn_list_add(&packed_lods, &packed_lod);
+  }
+
+  return (PackedMesh){
+    .vertices = pack_vertices(vertices, &quantization, packed_vertex_size, pack_vertex),
+    .indices = dyn_list_copy(indices),
+    .topology = topology,
+    .meshlets = dyn_list_copy(meshlets),
+    .lods = packed_lods,
+    .bounds_min = *bounds_min,
+    .bounds_max = *bounds_max,
+    .bounds_center = *bounds_center,
+    .bounds_radius = bounds_radius,
+    .quantization = quantization,
+  };
+}
+
+void packed_mesh_destroy(PackedMesh* mesh)
+{
+  dyn_list_destroy(&mesh->vertices);
+  dyn_list_destroy(&mesh->indices);
+  dyn_list_destroy(&mesh->meshlets);
+  mesh_lods_destroy(&mesh->lods);
+}
+
+static DynList pack_vertices(const DynList* vertices,
+                             const PositionQuantization* quantization,
+                             size_t packed_vertex_size,
+                             VertexPacker pack_vertex)
+{
+  DynList packed_vertices = dyn_list_make(packed_vertex_size);
+  dyn_list_reserve(&packed_vertices, vertices->size);
+  for (size_t i = 0; i < vertices->size; i++) {
+    pack_vertex(quantization, dyn_list_at(vertices, i), dyn_list_add_slot(&packed_vertices));
+  }
+  return packed_vertices;
+}
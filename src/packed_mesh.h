@@ -0,0 +1,42 @@
+#ifndef PACKED_MESH_H_
+#define PACKED_MESH_H_
+
+#include "dynlist.h"
+#include "index_buffer.h"
+#include "vector.h"
+#include "vertex_packing.h"
+
+#include <stddef.h>
+
+// A mesh whose vertices are stored in one of the packed layouts, e.g. `PackedNormalVertex`. Everything else, including
+// the bounds and meshlets, stays in object space. Made with `mesh_pack` on a regular mesh.
+typedef struct
+{
+  DynList vertices;
+  DynList indices;   // See `index_buffer.h`
+  PrimitiveTopology topology;
+  DynList meshlets;  // Meshlet, covering all triangles in order
+  DynList lods;      // MeshLod with packed vertices, from finest to coarsest
+  Vec3 bounds_min;
+  Vec3 bounds_max;
+  Vec3 bounds_center;
+  float bounds_radius;
+  PositionQuantization quantization;  // Shared by all LOD levels
+} PackedMesh;
+
+typedef void (*VertexPacker)(const PositionQuantization* quantization, const void* vertex, void* packed_vertex);
+
+PackedMesh packed_mesh_make(const DynList* vertices,
+                            const DynList* indices,
+                            PrimitiveTopology topology,
+                            const DynList* meshlets,
+                            const DynList* lods,
+                            const Vec3* bounds_min,
+                            const Vec3* bounds_max,
+                            const Vec3* bounds_center,
+                            float bounds_radius,
+                            size_t packed_vertex_size,
+                            VertexPacker pack_vertex);
+void packed_mesh_destroy(PackedMesh* mesh);
+
+#endif
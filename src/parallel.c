@@ -0,0 +1,72 @@
+#define _POSIX_C_SOURCE 200809L  // sysconf
+
+#include "parallel.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct
+{
+  void (*task)(void* context, size_t index);
+  void* context;
+  size_t num_tasks;
+  atomic_size_t next_task;
+} ParallelJob;
+
+static void* parallel_worker(void* arg);
+
+size_t parallel_num_threads(void)
+{
+  const long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+  return num_processors > 0 ? (size_t)num_processors : 1;
+}
+
+void parallel_for(size_t num_tasks, void task(void* context, size_t index), void* context)
+{
+  size_t num_threads = parallel_num_threads();
+  if (num_threads > num_tasks) num_threads = num_tasks;
+
+  if (num_threads <= 1) {
+    for (size_t i = 0; i < num_tasks; i++) {
+      task(context, i);
+    }
+    return;
+  }
+
+  ParallelJob job = {
+    .task = task,
+    .context = context,
+    .num_tasks = num_tasks,
+  };
+  atomic_init(&job.next_task, 0);
+
+  // The calling thread works through the tasks too, so they all get done however many threads start.
+  pthread_t* threads = malloc((num_threads - 1) * sizeof(pthread_t));
+  size_t num_started = 0;
+  while (num_started < num_threads - 1 && pthread_create(&threads[num_started], NULL, parallel_worker, &job) == 0) {
+    num_started++;
+  }
+
+  parallel_worker(&job);
+
+  for (size_t i = 0; i < num_started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+}
+
+static void* parallel_worker(void* arg)
+{
+  ParallelJob* job = arg;
+
+  while (true) {
+    const size_t index = atomic_fetch_add(&job->next_task, 1);
+    if (index >= job->num_tasks) break;
+    job->task(job->context, index);
+  }
+
+  return NULL;
+}
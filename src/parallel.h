@@ -0,0 +1,12 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <stddef.h>
+
+size_t parallel_num_threads(void);
+
+// Runs `task` for every index in [0, num_tasks) on up to `parallel_num_threads()` threads, including the calling one.
+// Returns once every task has finished. Tasks are handed out in order, but may finish in any order.
+void parallel_for(size_t num_tasks, void task(void* context, size_t index), void* context);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef PIPELINE_STATS_H_
+#define PIPELINE_STATS_H_
+
+#include <stddef.h>
+
+// Counts what the pipelines did with the meshes they were given. Draw calls add to the counts, so they can be summed
+// over a frame. Scenes that cull meshes on their own count those as culled too.
+typedef struct
+{
+  size_t meshes_drawn;
+  size_t meshes_culled;    // Entirely outside the frustum
+  size_t meshes_occluded;  // Hidden behind occluders (see `occlusion_buffer.h`)
+} PipelineStats;
+
+#endif
@@ -1,4 +1,2 @@
-#include "default_pipeline.h"
-
 #define PIPELINE_IMPLEMENTATION
-#include "pipeline.inc"
+#include "default_pipeline.h"
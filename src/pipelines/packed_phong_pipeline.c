@@ -0,0 +1,2 @@
+#define PIPELINE_IMPLEMENTATION
+#include "packed_phong_pipeline.h"
@@ -0,0 +1,16 @@
+#ifndef PACKED_PHONG_PIPELINE_H_
+#define PACKED_PHONG_PIPELINE_H_
+
+#include "packed_mesh.h"
+#include "effects/phong_effect.h"
+
+#define PIPELINE_TYPE_PREFIX            PackedPhong
+#define PIPELINE_FUNCTION_PREFIX        packed_phong_
+#define PIPELINE_MESH_TYPE              PackedMesh
+#define PIPELINE_EFFECT_TYPE            PhongEffect
+#define PIPELINE_EFFECT_FUNCTION_PREFIX phong_effect_
+#define PIPELINE_PACKED_VERTICES        true
+
+#include "pipeline.inc"
+
+#endif
@@ -0,0 +1,2 @@
+#define PIPELINE_IMPLEMENTATION
+#include "packed_texture_pipeline.h"
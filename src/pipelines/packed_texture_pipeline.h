@@ -0,0 +1,16 @@
+#ifndef PACKED_TEXTURE_PIPELINE_H_
+#define PACKED_TEXTURE_PIPELINE_H_
+
+#include "packed_mesh.h"
+#include "effects/texture_effect.h"
+
+#define PIPELINE_TYPE_PREFIX            PackedTexture
+#define PIPELINE_FUNCTION_PREFIX        packed_texture_
+#define PIPELINE_MESH_TYPE              PackedMesh
+#define PIPELINE_EFFECT_TYPE            TextureEffect
+#define PIPELINE_EFFECT_FUNCTION_PREFIX texture_effect_
+#define PIPELINE_PACKED_VERTICES        true
+
+#include "pipeline.inc"
+
+#endif
@@ -1,4 +1,2 @@
-#include "phong_pipeline.h"
-
 #define PIPELINE_IMPLEMENTATION
-#include "pipeline.inc"
+#include "phong_pipeline.h"
@@ -1,4 +1,2 @@
-#include "texture_pipeline.h"
-
 #define PIPELINE_IMPLEMENTATION
-#include "pipeline.inc"
+#include "texture_pipeline.h"
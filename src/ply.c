@@ -0,0 +1,512 @@
+#include "ply.h"
+
+#include "mapped_file.h"
+#include "vector.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MAX_HEADER_LINE_LENGTH 256
+#define MAX_NAME_LENGTH        32
+#define NO_PROPERTY            SIZE_MAX
+
+typedef enum {
+  PLY_INT8,
+  PLY_UINT8,
+  PLY_INT16,
+  PLY_UINT16,
+  PLY_INT32,
+  PLY_UINT32,
+  PLY_FLOAT32,
+  PLY_FLOAT64,
+} PlyType;
+
+typedef struct
+{
+  char name[MAX_NAME_LENGTH];
+  PlyType type;  // Of the items, for a list
+  bool is_list;
+  PlyType count_type;
+  size_t offset;  // From the start of the element, unless the element has lists
+} PlyProperty;
+
+typedef struct
+{
+  char name[MAX_NAME_LENGTH];
+  size_t count;
+  DynList properties;  // PlyProperty
+  size_t size;         // Of each item, unless the element has lists
+  bool has_lists;
+} PlyElement;
+
+typedef struct
+{
+  const unsigned char* ptr;
+  const unsigned char* end;
+  const char* path;
+} PlyReader;
+
+static bool ply_parse_header(PlyReader* reader, DynList* elements);
+static bool ply_parse_type(const char* name, PlyType* type);
+static size_t ply_type_size(PlyType type);
+static double ply_read_value(PlyType type, const unsigned char* data);
+static bool ply_read_count(const PlyReader* reader, const PlyProperty* property, size_t* count);
+static size_t ply_find_property(const PlyElement* element, const char* name);
+static size_t ply_min_item_size(const PlyElement* element);
+static bool ply_read_vertices(PlyReader* reader, const PlyElement* element, MeshSource* source);
+static bool ply_read_faces(PlyReader* reader,
+                           const PlyElement* element,
+                           size_t first_vertex,
+                           size_t num_vertices,
+                           MeshSource* source);
+static bool ply_skip_element(PlyReader* reader, const PlyElement* element);
+static void ply_elements_destroy(DynList* elements);
+
+// Reads the vertices and faces of a binary little endian PLY file, as written by most scanning software. Vertices keep
+// their normals (`nx`, `ny`, `nz`) and texture coordinates (`u`, `v` or `s`, `t`) if they have them, and polygons are
+// split into triangle fans. Values are read as they are stored, so the host has to be little endian too.
+bool ply_load_from_file(MeshSource* source, const char* path)
+{
+  MappedFile file = mapped_file_make();
+  if (!mapped_file_open(&file, path)) {
+    fprintf(stderr, "Failed to open PLY file: %s\n", path);
+    return false;
+  }
+
+  PlyReader reader = {
+    .ptr = file.data,
+    .end = file.data + file.size,
+    .path = path,
+  };
+  DynList elements = dyn_list_make(sizeof(PlyElement));
+  bool loaded = ply_parse_header(&reader, &elements);
+
+  size_t num_vertices = 0;
+  for (size_t i = 0; loaded && i < elements.size; i++) {
+    const PlyElement* element = dyn_list_at(&elements, i);
+    if (strcmp(element->name, "vertex") == 0) num_vertices = element->count;
+  }
+
+  const size_t first_vertex = source->positions.size;
+  for (size_t i = 0; loaded && i < elements.size; i++) {
+    const PlyElement* element = dyn_list_at(&elements, i);
+    if (strcmp(element->name, "vertex") == 0) {
+      loaded = ply_read_vertices(&reader, element, source);
+    } else if (strcmp(element->name, "face") == 0) {
+      loaded = ply_read_faces(&reader, element, first_vertex, num_vertices, source);
+    } else {
+      loaded = ply_skip_element(&reader, element);
+    }
+  }
+
+  ply_elements_destroy(&elements);
+  mapped_file_close(&file);
+  return loaded;
+}
+
+static bool ply_parse_header(PlyReader* reader, DynList* elements)
+{
+  bool first_line = true;
+  bool has_format = false;
+
+  for (;;) {
+    const unsigned char* newline = memchr(reader->ptr, '\n', reader->end - reader->ptr);
+    if (newline == NULL) {
+      fprintf(stderr, "PLY header has no end: %s\n", reader->path);
+      return false;
+    }
+
+    char line[MAX_HEADER_LINE_LENGTH];
+    size_t length = newline - reader->ptr;
+    if (length > 0 && reader->ptr[length - 1] == '\r') length--;
+    if (length >= sizeof(line)) length = sizeof(line) - 1;
+    memcpy(line, reader->ptr, length);
+    line[length] = '\0';
+    reader->ptr = newline + 1;
+
+    if (first_line) {
+      if (strcmp(line, "ply") != 0) {
+        fprintf(stderr, "Not a PLY file: %s\n", reader->path);
+        return false;
+      }
+      first_line = false;
+      continue;
+    }
+
+    char format[MAX_NAME_LENGTH];
+    char name[MAX_NAME_LENGTH];
+    char type[MAX_NAME_LENGTH];
+    char count_type[MAX_NAME_LENGTH];
+    size_t count;
+
+    if (strcmp(line, "end_header") == 0) {
+      if (!has_format) {
+        fprintf(stderr, "PLY header has no format: %s\n", reader->path);
+        return false;
+      }
+      return true;
+    }
+
+    if (sscanf(line, "format %31s", format) == 1) {
+      if (strcmp(format, "binary_little_endian") != 0) {
+        fprintf(stderr, "Unsupported PLY format %s: %s\n", format, reader->path);
+        return false;
+      }
+      has_format = true;
+    } else if (sscanf(line, "element %31s %zu", name, &count) == 2) {
+      PlyElement* element = dyn_list_add_slot(elements);
+      if (element == NULL) {
+        fprintf(stderr, "Failed to allocate PLY elements: %s\n", reader->path);
+        return false;
+      }
+      *element = (PlyElement){
+        .count = count,
+        .properties = dyn_list_make(sizeof(PlyProperty)),
+        .size = 0,
+        .has_lists = false,
+      };
+      memcpy(element->name, name, sizeof(name));
+    } else if (strncmp(line, "property", 8) == 0) {
+      if (elements->size == 0) {
+        fprintf(stderr, "PLY property outside of an element: %s\n", reader->path);
+        return false;
+      }
+      PlyElement* element = dyn_list_mutable_at(elements, elements->size - 1);
+
+      PlyProperty property = { .is_list = false };
+      bool valid;
+      if (sscanf(line, "property list %31s %31s %31s", count_type, type, name) == 3) {
+        property.is_list = true;
+        valid = ply_parse_type(count_type, &property.count_type) && ply_parse_type(type, &property.type);
+      } else {
+        valid = sscanf(line, "property %31s %31s", type, name) == 2 && ply_parse_type(type, &property.type);
+      }
+      if (!valid) {
+        fprintf(stderr, "Failed to read PLY property \"%s\": %s\n", line, reader->path);
+        return false;
+      }
+      memcpy(property.name, name, sizeof(name));
+
+      property.offset = element->size;
+      if (property.is_list) {
+        element->has_lists = true;
+      } else {
+        element->size += ply_type_size(property.type);
+      }
+      dyn_list_add(&element->properties, &property);
+    }
+  }
+}
+
+static bool ply_parse_type(const char* name, PlyType* type)
+{
+  static const struct
+  {
+    const char* name;
+    PlyType type;
+  } types[] = {
+    { "char", PLY_INT8 },      { "int8", PLY_INT8 },       { "uchar", PLY_UINT8 },    { "uint8", PLY_UINT8 },
+    { "short", PLY_INT16 },    { "int16", PLY_INT16 },     { "ushort", PLY_UINT16 },  { "uint16", PLY_UINT16 },
+    { "int", PLY_INT32 },      { "int32", PLY_INT32 },     { "uint", PLY_UINT32 },    { "uint32", PLY_UINT32 },
+    { "float", PLY_FLOAT32 },  { "float32", PLY_FLOAT32 }, { "double", PLY_FLOAT64 }, { "float64", PLY_FLOAT64 },
+  };
+
+  for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+    if (strcmp(name, types[i].name) == 0) {
+      *type = types[i].type;
+      return true;
+    }
+  }
+  return false;
+}
+
+static size_t ply_type_size(PlyType type)
+{
+  switch (type) {
+    case PLY_INT8:
+    case PLY_UINT8:
+      return 1;
+    case PLY_INT16:
+    case PLY_UINT16:
+      return 2;
+    case PLY_INT32:
+    case PLY_UINT32:
+    case PLY_FLOAT32:
+      return 4;
+    case PLY_FLOAT64:
+      return 8;
+  }
+  return 0;
+}
+
+static double ply_read_value(PlyType type, const unsigned char* data)
+{
+  switch (type) {
+    case PLY_INT8: {
+      int8_t value;
+      memcpy(&value, data, sizeof(value));
+      return value;
+    }
+    case PLY_UINT8:
+      return data[0];
+    case PLY_INT16: {
+      int16_t value;
+      memcpy(&value, data, sizeof(value));
+      return value;
+    }
+    case PLY_UINT16: {
+      uint16_t value;
+      memcpy(&value, data, sizeof(value));
+      return value;
+    }
+    case PLY_INT32: {
+      int32_t value;
+      memcpy(&value, data, sizeof(value));
+      return value;
+    }
+    case PLY_UINT32: {
+      uint32_t value;
+      memcpy(&value, data, sizeof(value));
+      return value;
+    }
+    case PLY_FLOAT32: {
+      float value;
+      memcpy(&value, data, sizeof(value));
+      return value;
+    }
+    case PLY_FLOAT64: {
+      double value;
+      memcpy(&value, data, sizeof(value));
+      return value;
+    }
+  }
+  return 0.0;
+}
+
+// Reads the count of a list property at the reader's position, which is 1 for other properties. Counts that don't fit
+// in a `size_t`, including negative ones, are rejected.
+static bool ply_read_count(const PlyReader* reader, const PlyProperty* property, size_t* count)
+{
+  if (!property->is_list) {
+    *count = 1;
+    return true;
+  }
+
+  const double value = ply_read_value(property->count_type, reader->ptr);
+  if (!(value >= 0.0 && value < (double)SIZE_MAX)) {
+    fprintf(stderr, "Invalid PLY list count: %s\n", reader->path);
+    return false;
+  }
+
+  *count = (size_t)value;
+  return true;
+}
+
+static size_t ply_find_property(const PlyElement* element, const char* name)
+{
+  for (size_t i = 0; i < element->properties.size; i++) {
+    const PlyProperty* property = dyn_list_at(&element->properties, i);
+    if (strcmp(property->name, name) == 0) return i;
+  }
+  return NO_PROPERTY;
+}
+
+// The fewest bytes an item of the element can take up, which is when its lists are empty.
+static size_t ply_min_item_size(const PlyElement* element)
+{
+  size_t size = 0;
+  for (size_t i = 0; i < element->properties.size; i++) {
+    const PlyProperty* property = dyn_list_at(&element->properties, i);
+    size += ply_type_size(property->is_list ? property->count_type : property->type);
+  }
+  return size;
+}
+
+// Vertices that are just three floats are copied over as they are.
+static bool ply_read_vertices(PlyReader* reader, const PlyElement* element, MeshSource* source)
+{
+  if (element->has_lists || element->size == 0) {
+    fprintf(stderr, "PLY vertices with list properties aren't supported: %s\n", reader->path);
+    return false;
+  }
+  if ((size_t)(reader->end - reader->ptr) / element->size < element->count) {
+    fprintf(stderr, "PLY file is truncated: %s\n", reader->path);
+    return false;
+  }
+
+  const char* names[7] = { "x", "y", "z", "nx", "ny", "nz", "u" };
+  size_t properties[8];
+  for (size_t i = 0; i < 7; i++) {
+    properties[i] = ply_find_property(element, names[i]);
+  }
+  properties[7] = ply_find_property(element, "v");
+  if (properties[6] == NO_PROPERTY || properties[7] == NO_PROPERTY) {
+    properties[6] = ply_find_property(element, "s");
+    properties[7] = ply_find_property(element, "t");
+  }
+
+  if (properties[0] == NO_PROPERTY || properties[1] == NO_PROPERTY || properties[2] == NO_PROPERTY) {
+    fprintf(stderr, "PLY vertices have no position: %s\n", reader->path);
+    return false;
+  }
+  // Attributes that earlier vertices don't have would be of no use.
+  const bool has_normals = properties[3] != NO_PROPERTY && properties[4] != NO_PROPERTY &&
+                           properties[5] != NO_PROPERTY && source->normals.size == source->positions.size;
+  const bool has_uvs =
+    properties[6] != NO_PROPERTY && properties[7] != NO_PROPERTY && source->uvs.size == source->positions.size;
+
+  PlyProperty attributes[8];
+  for (size_t i = 0; i < 8; i++) {
+    if (properties[i] != NO_PROPERTY) {
+      attributes[i] = *(const PlyProperty*)dyn_list_at(&element->properties, properties[i]);
+    }
+  }
+
+  const bool packed_positions = element->size == sizeof(Vec3) && attributes[0].type == PLY_FLOAT32 &&
+                                attributes[1].type == PLY_FLOAT32 && attributes[2].type == PLY_FLOAT32 &&
+                                attributes[0].offset == 0 && attributes[1].offset == 4 && attributes[2].offset == 8;
+  bool reserved = dyn_list_reserve(&source->positions, source->positions.size + element->count);
+  if (has_normals) reserved = reserved && dyn_list_reserve(&source->normals, source->normals.size + element->count);
+  if (has_uvs) reserved = reserved && dyn_list_reserve(&source->uvs, source->uvs.size + element->count);
+  if (!reserved) {
+    fprintf(stderr, "Failed to allocate PLY vertices: %s\n", reader->path);
+    return false;
+  }
+
+  if (packed_positions) {
+    dyn_list_append(&source->positions, reader->ptr, element->count);
+    reader->ptr += element->count * element->size;
+    return true;
+  }
+
+  for (size_t i = 0; i < element->count; i++, reader->ptr += element->size) {
+    float values[8];
+    for (size_t j = 0; j < 8; j++) {
+      values[j] = properties[j] != NO_PROPERTY ? ply_read_value(attributes[j].type, reader->ptr + attributes[j].offset)
+                                               : 0.0f;
+    }
+
+    const Vec3 pos = vec3_make(values[0], values[1], values[2]);
+    dyn_list_add(&source->positions, &pos);
+    if (has_normals) {
+      const Vec3 normal = vec3_make(values[3], values[4], values[5]);
+      dyn_list_add(&source->normals, &normal);
+    }
+    if (has_uvs) {
+      const Vec2 uv = vec2_make(values[6], values[7]);
+      dyn_list_add(&source->uvs, &uv);
+    }
+  }
+  return true;
+}
+
+static bool ply_read_faces(PlyReader* reader,
+                           const PlyElement* element,
+                           size_t first_vertex,
+                           size_t num_vertices,
+                           MeshSource* source)
+{
+  size_t indices_property = ply_find_property(element, "vertex_indices");
+  if (indices_property == NO_PROPERTY) indices_property = ply_find_property(element, "vertex_index");
+  if (indices_property == NO_PROPERTY ||
+      !((const PlyProperty*)dyn_list_at(&element->properties, indices_property))->is_list) {
+    fprintf(stderr, "PLY faces have no vertex indices: %s\n", reader->path);
+    return false;
+  }
+
+  // Bounds the count from the header before anything is allocated for it.
+  if ((size_t)(reader->end - reader->ptr) / ply_min_item_size(element) < element->count) {
+    fprintf(stderr, "PLY file is truncated: %s\n", reader->path);
+    return false;
+  }
+  if (!dyn_list_reserve(&source->indices, source->indices.size + 3 * element->count)) {
+    fprintf(stderr, "Failed to allocate PLY faces: %s\n", reader->path);
+    return false;
+  }
+
+  for (size_t i = 0; i < element->count; i++) {
+    for (size_t j = 0; j < element->properties.size; j++) {
+      const PlyProperty* property = dyn_list_at(&element->properties, j);
+      const size_t count_size = property->is_list ? ply_type_size(property->count_type) : 0;
+      if ((size_t)(reader->end - reader->ptr) < count_size) {
+        fprintf(stderr, "PLY file is truncated: %s\n", reader->path);
+        return false;
+      }
+
+      size_t count;
+      if (!ply_read_count(reader, property, &count)) return false;
+      const size_t item_size = ply_type_size(property->type);
+      reader->ptr += count_size;
+      if ((size_t)(reader->end - reader->ptr) / item_size < count) {
+        fprintf(stderr, "PLY file is truncated: %s\n", reader->path);
+        return false;
+      }
+
+      if (j == indices_property) {
+        size_t first = 0;
+        size_t previous = 0;
+        for (size_t k = 0; k < count; k++) {
+          const double value = ply_read_value(property->type, reader->ptr + k * item_size);
+          if (value < 0.0 || value >= num_vertices) {
+            fprintf(stderr, "PLY face %zu refers to a missing vertex: %s\n", i, reader->path);
+            return false;
+          }
+
+          const size_t index = first_vertex + (size_t)value;
+          if (k == 0) first = index;
+          if (k >= 2) {
+            dyn_list_add(&source->indices, &first);
+            dyn_list_add(&source->indices, &previous);
+            dyn_list_add(&source->indices, &index);
+          }
+          previous = index;
+        }
+      }
+      reader->ptr += count * item_size;
+    }
+  }
+  return true;
+}
+
+static bool ply_skip_element(PlyReader* reader, const PlyElement* element)
+{
+  if (!element->has_lists) {
+    if (element->size > 0 && (size_t)(reader->end - reader->ptr) / element->size < element->count) {
+      fprintf(stderr, "PLY file is truncated: %s\n", reader->path);
+      return false;
+    }
+    reader->ptr += element->count * element->size;
+    return true;
+  }
+
+  for (size_t i = 0; i < element->count; i++) {
+    for (size_t j = 0; j < element->properties.size; j++) {
+      const PlyProperty* property = dyn_list_at(&element->properties, j);
+      const size_t count_size = property->is_list ? ply_type_size(property->count_type) : 0;
+      if ((size_t)(reader->end - reader->ptr) < count_size) {
+        fprintf(stderr, "PLY file is truncated: %s\n", reader->path);
+        return false;
+      }
+
+      size_t count;
+      if (!ply_read_count(reader, property, &count)) return false;
+      reader->ptr += count_size;
+      if ((size_t)(reader->end - reader->ptr) / ply_type_size(property->type) < count) {
+        fprintf(stderr, "PLY file is truncated: %s\n", reader->path);
+        return false;
+      }
+      reader->ptr += count * ply_type_size(property->type);
+    }
+  }
+  return true;
+}
+
+static void ply_elements_destroy(DynList* elements)
+{
+  for (size_t i = 0; i < elements->size; i++) {
+    PlyElement* element = dyn_list_mutable_at(elements, i);
+    dyn_list_destroy(&element->properties);
+  }
+  dyn_list_destroy(elements);
+}
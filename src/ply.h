@@ -0,0 +1,10 @@
+#ifndef PLY_H_
+#define PLY_H_
+
+#include "mesh_source.h"
+
+#include <stdbool.h>
+
+bool ply_load_from_file(MeshSource* source, const char* path);
+
+#endif
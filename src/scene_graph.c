@@ -0,0 +1,134 @@
+#include "scene_graph.h"
+
+#include "frustum.h"
+
+#include <stdlib.h>
+#include <tgmath.h>
+
+static void scene_object_world_bounds(const SceneObject* object, Vec3* min, Vec3* max);
+
+SceneGraph scene_graph_make(void)
+{
+  return (SceneGraph){
+    .objects = dyn_list_make(sizeof(SceneObject)),
+    .bvh = bvh_make(),
+    .bvh_stale = false,
+  };
+}
+
+void scene_graph_destroy(SceneGraph* graph)
+{
+  dyn_list_destroy(&graph->objects);
+  bvh_destroy(&graph->bvh);
+}
+
+// Returns the index of the new object.
+size_t scene_graph_add(SceneGraph* graph,
+                       const Mat4* transform,
+                       const Vec3* bounds_min,
+                       const Vec3* bounds_max,
+                       size_t model,
+                       bool occluder)
+{
+  const SceneObject object = {
+    .transform = *transform,
+    .bounds_min = *bounds_min,
+    .bounds_max = *bounds_max,
+    .model = model,
+    .occluder = occluder,
+  };
+  dyn_list_add(&graph->objects, &object);
+  graph->bvh_stale = true;
+  return graph->objects.size - 1;
+}
+
+void scene_graph_update(SceneGraph* graph,
+                        size_t object,
+                        const Mat4* transform,
+                        const Vec3* bounds_min,
+                        const Vec3* bounds_max)
+{
+  SceneObject* o = dyn_list_mutable_at(&graph->objects, object);
+  o->transform = *transform;
+  o->bounds_min = *bounds_min;
+  o->bounds_max = *bounds_max;
+  if (graph->bvh_stale) return;
+
+  Vec3 min;
+  Vec3 max;
+  scene_object_world_bounds(o, &min, &max);
+  bvh_refit(&graph->bvh, object, &min, &max);
+}
+
+const SceneObject* scene_graph_get(const SceneGraph* graph, size_t object)
+{
+  return dyn_list_at(&graph->objects, object);
+}
+
+// Adds the index of every object that may be visible through `proj_view`, which takes world space to clip space, to
+// `visible` (size_t).
+void scene_graph_cull(SceneGraph* graph, const Mat4* proj_view, DynList* visible)
+{
+  if (graph->bvh_stale) {
+    const size_t num_objects = graph->objects.size;
+    Vec3* bounds = malloc(2 * num_objects * sizeof(Vec3));
+    for (size_t i = 0; i < num_objects; i++) {
+      scene_object_world_bounds(dyn_list_at(&graph->objects, i), &bounds[i], &bounds[num_objects + i]);
+    }
+    bvh_build(&graph->bvh, bounds, bounds + num_objects, num_objects);
+    free(bounds);
+    graph->bvh_stale = false;
+  }
+
+  const Frustum frustum = frustum_make(proj_view);
+  bvh_cull(&graph->bvh, &frustum, visible);
+}
+
+// Removes the objects in `visible` (size_t) that are hidden behind the occluders drawn into `occlusion`, keeping the
+// others in order. Returns how many were removed.
+size_t scene_graph_cull_occluded(const SceneGraph* graph,
+                                 const OcclusionBuffer* occlusion,
+                                 const Mat4* proj_view,
+                                 DynList* visible)
+{
+  size_t* objects = (size_t*)visible->buffer;
+  size_t num_visible = 0;
+  for (size_t i = 0; i < visible->size; i++) {
+    const SceneObject* object = scene_graph_get(graph, objects[i]);
+    const Mat4 proj_world = mat4_mul(proj_view, &object->transform);
+    if (occlusion_buffer_box_visible(occlusion, &proj_world, &object->bounds_min, &object->bounds_max)) {
+      objects[num_visible++] = objects[i];
+    }
+  }
+
+  const size_t num_occluded = visible->size - num_visible;
+  visible->size = num_visible;
+  return num_occluded;
+}
+
+// The box around the transformed object space box (Arvo): its center is transformed as a point, and each half extent
+// is the sum of the absolute values the rotation and scale spread the others over.
+static void scene_object_world_bounds(const SceneObject* object, Vec3* min, Vec3* max)
+{
+  const float (*m)[4] = object->transform.elements;
+  const Vec3 center = vec3_make((object->bounds_min.x + object->bounds_max.x) / 2.0f,
+                                (object->bounds_min.y + object->bounds_max.y) / 2.0f,
+                                (object->bounds_min.z + object->bounds_max.z) / 2.0f);
+  const Vec3 half_extent = vec3_sub(&object->bounds_max, &center);
+
+  const float c[3] = { center.x, center.y, center.z };
+  const float e[3] = { half_extent.x, half_extent.y, half_extent.z };
+  float world_center[3];
+  float world_extent[3];
+  for (int i = 0; i < 3; i++) {
+    world_center[i] = m[i][0] * c[0] + m[i][1] * c[1] + m[i][2] * c[2] + m[i][3];
+    world_extent[i] = fabs(m[i][0]) * e[0] + fabs(m[i][1]) * e[1] + fabs(m[i][2]) * e[2];
+  }
+
+  *min = vec3_make(world_center[0] - world_extent[0],
+                   world_center[1] - world_extent[1],
+                   world_center[2] - world_extent[2]);
+  *max = vec3_make(world_center[0] + world_extent[0],
+                   world_center[1] + world_extent[1],
+                   world_center[2] + world_extent[2]);
+}
@@ -0,0 +1,53 @@
+#ifndef SCENE_GRAPH_H_
+#define SCENE_GRAPH_H_
+
+#include "bvh.h"
+#include "dynlist.h"
+#include "matrix.h"
+#include "occlusion_buffer.h"
+#include "vector.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// An instance of a model somewhere in the world. What `model` refers to is up to the scene, e.g. an index into its
+// meshes.
+typedef struct
+{
+  Mat4 transform;   // From object to world space
+  Vec3 bounds_min;  // In object space
+  Vec3 bounds_max;
+  size_t model;
+  bool occluder;  // Drawn into the occlusion buffer before the others are tested against it
+} SceneObject;
+
+// Objects that can be culled against a frustum together, through a BVH over their world space bounds. Moving objects
+// only refits the BVH, which is rebuilt when objects are added.
+typedef struct
+{
+  DynList objects;  // SceneObject
+  Bvh bvh;
+  bool bvh_stale;
+} SceneGraph;
+
+SceneGraph scene_graph_make(void);
+void scene_graph_destroy(SceneGraph* graph);
+size_t scene_graph_add(SceneGraph* graph,
+                       const Mat4* transform,
+                       const Vec3* bounds_min,
+                       const Vec3* bounds_max,
+                       size_t model,
+                       bool occluder);
+void scene_graph_update(SceneGraph* graph,
+                        size_t object,
+                        const Mat4* transform,
+                        const Vec3* bounds_min,
+                        const Vec3* bounds_max);
+const SceneObject* scene_graph_get(const SceneGraph* graph, size_t object);
+void scene_graph_cull(SceneGraph* graph, const Mat4* proj_view, DynList* visible);
+size_t scene_graph_cull_occluded(const SceneGraph* graph,
+                                 const OcclusionBuffer* occlusion,
+                                 const Mat4* proj_view,
+                                 DynList* visible);
+
+#endif
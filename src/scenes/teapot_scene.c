@@ -5,23 +5,61 @@
 #include "effects/phong_effect.h"
 
 #include <SDL.h>
+#include <stddef.h>
 #include <stdlib.h>
 
+#define OCCLUSION_WIDTH  256
+#define OCCLUSION_HEIGHT 128
+
+#define TEXTURE_WORKERS       1
+#define TEXTURE_MEMORY_BUDGET (64 * 1024 * 1024)
+#define WALL_TEXTURE_SLOTS    4
+
+// What the scene graph's objects are instances of.
+#define TEAPOT_MODEL 0
+#define FLOOR_MODEL  1
+#define WALL_MODEL   2
+
+static void teapot_scene_finish_mesh(TeapotScene* scene);
+static void teapot_scene_update_bounds(TeapotScene* scene);
+static void teapot_scene_draw_occluders(TeapotScene* scene, const Mat4* proj_view);
 static void teapot_scene_update_camera(TeapotScene* scene);
 
 TeapotScene teapot_scene_make(const Graphics* graphics)
 {
   DepthBuffer* depth_buffer = depth_buffer_make(graphics->screen_width, graphics->screen_height);
 
+  // Drawn as it loads.
   NormalMesh mesh = normal_mesh_make();
-  normal_mesh_load_from_file(&mesh, "resources/teapot.obj", false, false);
-  normal_mesh_interpolate_normals(&mesh);
+  NormalMeshStream* mesh_stream = normal_mesh_stream_begin("resources/teapot.obj", false, false);
+  if (mesh_stream == NULL) normal_mesh_load_from_file(&mesh, "resources/teapot.obj", false, false);
 
   PhongPipeline pipeline = phong_pipeline_make(graphics, depth_buffer);
 
   const Mat4 projection = mat4_projection(90.0f, 4.0f / 3.0f, 0.01f, 10.0f);
   phong_effect_set_projection(&pipeline.effect, &projection);
 
+  // The floor's texture is decoded in the background, and drawn from its placeholder until then. Without a texture
+  // manager, there is no floor.
+  TextureMesh floor_mesh = texture_mesh_make();
+  texture_mesh_load_from_file(&floor_mesh, "resources/floor.obj", true, false);
+  TexturePipeline texture_pipeline = texture_pipeline_make(graphics, depth_buffer);
+  texture_effect_set_projection(&texture_pipeline.effect, &projection);
+
+  TextureManager* textures = texture_manager_make(TEXTURE_WORKERS, TEXTURE_FORMAT_BC1, TEXTURE_MEMORY_BUDGET);
+  const size_t floor_texture = textures != NULL ? texture_manager_request(textures, "resources/rocky.png") : 0;
+
+  // The wall's texture is paged in as it's sampled, from a block-compressed copy.
+  Texture* wall_source = texture_make();
+  VirtualTexture* wall_texture = NULL;
+  if (texture_load_cached(wall_source, "resources/rocky.png", TEXTURE_FORMAT_BC1)) {
+    wall_texture = virtual_texture_make(wall_source->width,
+                                        wall_source->height,
+                                        WALL_TEXTURE_SLOTS,
+                                        virtual_texture_load_page_from_texture,
+                                        wall_source);
+  }
+
   const Vec4 light_pos_base = vec4_make(0.0f, 1.0f, 3.5f, 1.0f);
   const Vec3 ambient_light = vec3_make(0.24725f, 0.2245f, 0.0645f);
   const Vec3 diffuse_light = vec3_make(0.34615f, 0.3143f, 0.0903f);
@@ -40,10 +78,38 @@ TeapotScene teapot_scene_make(const Graphics* graphics)
   const Vec3 camera_forward_base = vec3_make(0.0f, 0.0f, -1.0f);
   const Vec3 camera_left_base = vec3_make(-1.0f, 0.0f, 0.0f);
 
+  SceneGraph graph = scene_graph_make();
+  const Mat4 teapot_transform = mat4_identity();
+  const size_t teapot =
+    scene_graph_add(&graph, &teapot_transform, &mesh.bounds_min, &mesh.bounds_max, TEAPOT_MODEL, true);
+  const Mat4 floor_transform = mat4_identity();
+  if (textures != NULL) {
+    scene_graph_add(&graph, &floor_transform, &floor_mesh.bounds_min, &floor_mesh.bounds_max, FLOOR_MODEL, false);
+  }
+  const Mat4 wall_translation = mat4_translation(0.0f, 4.0f, -3.0f);
+  const Mat4 wall_rotation = mat4_rotation_x(M_PI / 2.0f);
+  const Mat4 wall_transform = mat4_mul(&wall_translation, &wall_rotation);
+  if (wall_texture != NULL) {
+    scene_graph_add(&graph, &wall_transform, &floor_mesh.bounds_min, &floor_mesh.bounds_max, WALL_MODEL, false);
+  }
+
   TeapotScene scene = {
     .depth_buffer = depth_buffer,
     .mesh = mesh,
+    .mesh_stream = mesh_stream,
     .pipeline = pipeline,
+    .floor_mesh = floor_mesh,
+    .texture_pipeline = texture_pipeline,
+    .textures = textures,
+    .floor_texture = floor_texture,
+    .wall_source = wall_source,
+    .wall_texture = wall_texture,
+    .graph = graph,
+    .teapot = teapot,
+    .visible = dyn_list_make(sizeof(size_t)),
+    .occlusion = occlusion_buffer_make(OCCLUSION_WIDTH, OCCLUSION_HEIGHT),
+    .stats = { .meshes_drawn = 0, .meshes_culled = 0, .meshes_occluded = 0 },
+    .view = mat4_identity(),
     .light_pos_base = light_pos_base,
     .light_pos = light_pos_base,
     .camera_pos = vec3_make(0.0f, 1.0f, 6.0f),
@@ -54,6 +120,7 @@ TeapotScene teapot_scene_make(const Graphics* graphics)
     .camera_left = camera_left_base,
   };
 
+  if (mesh_stream == NULL) teapot_scene_finish_mesh(&scene);
   teapot_scene_update_camera(&scene);
 
   return scene;
@@ -63,10 +130,27 @@ void teapot_scene_destroy(TeapotScene* scene)
 {
   depth_buffer_destroy(scene->depth_buffer);
   normal_mesh_destroy(&scene->mesh);
+  if (scene->mesh_stream != NULL) normal_mesh_stream_destroy(scene->mesh_stream);
+  texture_mesh_destroy(&scene->floor_mesh);
+  if (scene->textures != NULL) texture_manager_destroy(scene->textures);
+  if (scene->wall_texture != NULL) virtual_texture_destroy(scene->wall_texture);
+  texture_destroy(scene->wall_source);
+  scene_graph_destroy(&scene->graph);
+  dyn_list_destroy(&scene->visible);
+  occlusion_buffer_destroy(&scene->occlusion);
 }
 
 void teapot_scene_update(TeapotScene* scene, float dt)
 {
+  if (scene->mesh_stream != NULL) {
+    if (normal_mesh_stream_update(scene->mesh_stream, &scene->mesh)) {
+      normal_mesh_stream_destroy(scene->mesh_stream);
+      scene->mesh_stream = NULL;
+      teapot_scene_finish_mesh(scene);
+    }
+    teapot_scene_update_bounds(scene);
+  }
+
   const uint8_t* key_states = SDL_GetKeyboardState(NULL);
 
   const double angular_speed = 2.5f;
@@ -105,6 +189,25 @@ void teapot_scene_update(TeapotScene* scene, float dt)
   }
 }
 
+static void teapot_scene_finish_mesh(TeapotScene* scene)
+{
+  normal_mesh_interpolate_normals(&scene->mesh, NULL);
+
+  const float lod_ratios[] = { 0.5f, 0.25f, 0.1f };
+  normal_mesh_build_lods(&scene->mesh, lod_ratios, sizeof(lod_ratios) / sizeof(lod_ratios[0]));
+  normal_mesh_build_streams(&scene->mesh);
+  normal_mesh_build_strips(&scene->mesh);
+  normal_mesh_finalize(&scene->mesh);
+}
+
+// The teapot's bounds grow while it's loading.
+static void teapot_scene_update_bounds(TeapotScene* scene)
+{
+  const SceneObject* teapot = scene_graph_get(&scene->graph, scene->teapot);
+  scene_graph_update(
+    &scene->graph, scene->teapot, &teapot->transform, &scene->mesh.bounds_min, &scene->mesh.bounds_max);
+}
+
 static void teapot_scene_update_camera(TeapotScene* scene)
 {
   const Mat3 camera_rot_y = mat3_rotation_y(scene->camera_angles.y);
@@ -116,17 +219,77 @@ static void teapot_scene_update_camera(TeapotScene* scene)
   const Mat4 world_rot_z = mat4_rotation_z(-scene->camera_angles.z);
   const Mat4 world_trans = mat4_translation(-scene->camera_pos.x, -scene->camera_pos.y, -scene->camera_pos.z);
 
-  Mat4 world = world_rot_x;
-  world = mat4_mul(&world, &world_rot_y);
-  world = mat4_mul(&world, &world_rot_z);
-  world = mat4_mul(&world, &world_trans);
-  phong_effect_set_world(&scene->pipeline.effect, &world);
+  Mat4 view = world_rot_x;
+  view = mat4_mul(&view, &world_rot_y);
+  view = mat4_mul(&view, &world_rot_z);
+  view = mat4_mul(&view, &world_trans);
+  scene->view = view;
 
-  scene->light_pos = mat4_vec_mul(&world, &scene->light_pos_base);
+  scene->light_pos = mat4_vec_mul(&view, &scene->light_pos_base);
   phong_effect_set_light_pos(&scene->pipeline.effect, &scene->light_pos);
 }
 
+// Only the objects that the scene graph finds in the frustum, and not behind any occluders, are drawn.
 void teapot_scene_draw(TeapotScene* scene)
 {
-  phong_pipeline_draw(&scene->pipeline, &scene->mesh);
+  depth_buffer_clear(scene->depth_buffer);
+
+  const Mat4 proj_view = mat4_mul(&scene->pipeline.effect.projection, &scene->view);
+  scene->visible.size = 0;
+  scene_graph_cull(&scene->graph, &proj_view, &scene->visible);
+
+  scene->stats = (PipelineStats){
+    .meshes_drawn = 0,
+    .meshes_culled = scene->graph.objects.size - scene->visible.size,
+    .meshes_occluded = 0,
+  };
+
+  teapot_scene_draw_occluders(scene, &proj_view);
+  scene->stats.meshes_occluded =
+    scene_graph_cull_occluded(&scene->graph, &scene->occlusion, &proj_view, &scene->visible);
+
+  for (size_t i = 0; i < scene->visible.size; i++) {
+    const SceneObject* object = scene_graph_get(&scene->graph, *(const size_t*)dyn_list_at(&scene->visible, i));
+    const Mat4 world = mat4_mul(&scene->view, &object->transform);
+    if (object->model == FLOOR_MODEL) {
+      const Texture* texture = texture_manager_get(scene->textures, scene->floor_texture);
+      texture_effect_set_texture(&scene->texture_pipeline.effect, texture);
+      texture_effect_set_world(&scene->texture_pipeline.effect, &world);
+      texture_pipeline_draw(&scene->texture_pipeline, &scene->floor_mesh, &scene->stats);
+    } else if (object->model == WALL_MODEL) {
+      texture_effect_set_virtual_texture(&scene->texture_pipeline.effect, scene->wall_texture);
+      texture_effect_set_world(&scene->texture_pipeline.effect, &world);
+      texture_pipeline_draw(&scene->texture_pipeline, &scene->floor_mesh, &scene->stats);
+      texture_effect_set_virtual_texture(&scene->texture_pipeline.effect, NULL);
+    } else {
+      phong_effect_set_world(&scene->pipeline.effect, &world);
+      phong_pipeline_draw(&scene->pipeline, &scene->mesh, &scene->stats);
+    }
+  }
+
+  // Pages sampled during the frame are loaded for the next one.
+  if (scene->wall_texture != NULL) virtual_texture_update(scene->wall_texture);
+  if (scene->textures != NULL) texture_manager_end_frame(scene->textures);
+}
+
+// Occluders are drawn from the teapot's coarsest level, which only uses vertices of the full mesh, so that it stays
+// inside the same bounds. Nothing occludes while the teapot is still loading.
+static void teapot_scene_draw_occluders(TeapotScene* scene, const Mat4* proj_view)
+{
+  occlusion_buffer_clear(&scene->occlusion);
+  if (scene->mesh.lods.size == 0) return;
+
+  const MeshLod* lod = dyn_list_at(&scene->mesh.lods, scene->mesh.lods.size - 1);
+  for (size_t i = 0; i < scene->visible.size; i++) {
+    const SceneObject* object = scene_graph_get(&scene->graph, *(const size_t*)dyn_list_at(&scene->visible, i));
+    if (!object->occluder) continue;
+
+    const Mat4 proj_world = mat4_mul(proj_view, &object->transform);
+    occlusion_buffer_draw(&scene->occlusion,
+                          &proj_world,
+                          (const unsigned char*)lod->vertices.buffer + offsetof(NormalVertex, pos),
+                          sizeof(NormalVertex),
+                          lod->vertices.size,
+                          &lod->indices);
+  }
 }
@@ -3,15 +3,37 @@
 
 #include "graphics.h"
 #include "depth_buffer.h"
+#include "dynlist.h"
+#include "matrix.h"
+#include "occlusion_buffer.h"
+#include "pipeline_stats.h"
+#include "scene_graph.h"
+#include "texture_manager.h"
 #include "vector.h"
+#include "virtual_texture.h"
 #include "pipelines/phong_pipeline.h"
+#include "pipelines/texture_pipeline.h"
 #include "meshes/normal_mesh.h"
+#include "meshes/texture_mesh.h"
 
 typedef struct
 {
   DepthBuffer* depth_buffer;
   NormalMesh mesh;
+  NormalMeshStream* mesh_stream;  // NULL once the mesh is loaded
   PhongPipeline pipeline;
+  TextureMesh floor_mesh;  // Also drawn upright as the wall
+  TexturePipeline texture_pipeline;
+  TextureManager* textures;      // NULL if it couldn't be started
+  size_t floor_texture;          // In `textures`
+  Texture* wall_source;          // Paged into `wall_texture`
+  VirtualTexture* wall_texture;  // NULL if its source couldn't be loaded
+  SceneGraph graph;
+  size_t teapot;  // In `graph`
+  DynList visible;      // size_t, the objects of `graph` drawn in the last frame
+  OcclusionBuffer occlusion;
+  PipelineStats stats;  // Of the last frame drawn
+  Mat4 view;
   Vec4 light_pos_base;
   Vec4 light_pos;
   Vec3 camera_pos;
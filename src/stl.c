@@ -0,0 +1,96 @@
+#include "stl.h"
+
+#include "hash_map.h"
+#include "mapped_file.h"
+#include "vector.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define STL_HEADER_SIZE   80
+#define STL_TRIANGLE_SIZE 50  // Facet normal, three corners and a 16-bit attribute
+
+// Corners with equal keys become the same vertex.
+typedef struct
+{
+  Vec3 pos;
+  Vec3 normal;  // Zero unless normals are loaded
+} StlCorner;
+
+static uint64_t stl_corner_hash(const void* corner);
+static bool stl_corners_equal(const void* a, const void* b);
+
+// Reads a binary STL file, which stores every triangle with its own copy of its corners. Corners are merged with a hash
+// map, by position and, when normals are loaded, by facet normal as well, which shades the mesh flat. Like the mesh
+// cache, this assumes a little endian host. ASCII STL files aren't supported.
+bool stl_load_from_file(MeshSource* source, const char* path, bool load_normals)
+{
+  MappedFile file = mapped_file_make();
+  if (!mapped_file_open(&file, path)) {
+    fprintf(stderr, "Failed to open STL file: %s\n", path);
+    return false;
+  }
+
+  uint32_t num_triangles = 0;
+  if (file.size >= STL_HEADER_SIZE + sizeof(uint32_t)) {
+    memcpy(&num_triangles, file.data + STL_HEADER_SIZE, sizeof(uint32_t));
+  }
+  if (file.size < STL_HEADER_SIZE + sizeof(uint32_t) ||
+      file.size != STL_HEADER_SIZE + sizeof(uint32_t) + (size_t)num_triangles * STL_TRIANGLE_SIZE) {
+    fprintf(stderr, "Not a binary STL file: %s\n", path);
+    mapped_file_close(&file);
+    return false;
+  }
+
+  if (!dyn_list_reserve(&source->indices, source->indices.size + 3 * (size_t)num_triangles)) {
+    fprintf(stderr, "Failed to allocate STL triangles: %s\n", path);
+    mapped_file_close(&file);
+    return false;
+  }
+  HashMap corners_seen = hash_map_make(sizeof(StlCorner), stl_corner_hash, stl_corners_equal);
+
+  const unsigned char* triangle = file.data + STL_HEADER_SIZE + sizeof(uint32_t);
+  for (size_t i = 0; i < num_triangles; i++, triangle += STL_TRIANGLE_SIZE) {
+    float values[12];
+    memcpy(values, triangle, sizeof(values));
+
+    StlCorner corner = {
+      .normal = load_normals ? vec3_make(values[0], values[1], values[2]) : vec3_make(0.0f, 0.0f, 0.0f),
+    };
+    for (size_t k = 0; k < 3; k++) {
+      corner.pos = vec3_make(values[3 + 3 * k], values[4 + 3 * k], values[5 + 3 * k]);
+
+      size_t index;
+      if (!hash_map_find(&corners_seen, &corner, &index)) {
+        index = source->positions.size;
+        hash_map_insert(&corners_seen, &corner, index);
+        dyn_list_add(&source->positions, &corner.pos);
+        if (load_normals) dyn_list_add(&source->normals, &corner.normal);
+      }
+      dyn_list_add(&source->indices, &index);
+    }
+  }
+
+  hash_map_destroy(&corners_seen);
+  mapped_file_close(&file);
+  return true;
+}
+
+static uint64_t stl_corner_hash(const void* corner)
+{
+  uint64_t words[sizeof(StlCorner) / sizeof(uint64_t)];
+  memcpy(words, corner, sizeof(words));
+
+  uint64_t hash = 0;
+  for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+    hash = hash_mix(hash ^ words[i]);
+  }
+  return hash;
+}
+
+// Compares bit patterns, so that only corners that were written identically are merged.
+static bool stl_corners_equal(const void* a, const void* b)
+{
+  return memcmp(a, b, sizeof(StlCorner)) == 0;
+}
@@ -0,0 +1,10 @@
+#ifndef STL_H_
+#define STL_H_
+
+#include "mesh_source.h"
+
+#include <stdbool.h>
+
+bool stl_load_from_file(MeshSource* source, const char* path, bool load_normals);
+
+#endif
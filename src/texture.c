@@ -1,19 +1,83 @@
 #include "texture.h"
 
+#include "block_compression.h"
+#include "utility.h"
 #include "stb_image.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <tgmath.h>
 #include <assert.h>
 
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+// Decoded blocks are kept in a small direct-mapped cache per thread, so that neighbouring samples don't decode the
+// same block over and over. The slot is picked from the low bits of the block coordinates, which keeps an 8x8 area of
+// blocks resident at once.
+#define BLOCK_CACHE_SIZE 64
+
+typedef struct
+{
+  unsigned int texture_id;
+  size_t block_index;
+  Color texels[BLOCK_NUM_TEXELS];
+} CachedBlock;
+
+static _Thread_local CachedBlock block_cache[BLOCK_CACHE_SIZE];
+static atomic_uint next_texture_id = 1;
+
+// Converted textures are cached next to their source file, in exactly the layout `Texture` uses in memory, so that they
+// can be mapped straight back in. The cache is tied to the source by a hash of its contents.
+#define TEXTURE_CACHE_MAGIC     "BLOOPTEX"
+#define TEXTURE_CACHE_VERSION   1
+#define TEXTURE_CACHE_EXTENSION ".texcache"
+
+#define DDS_HEADER_SIZE       128
+#define DDS_MAX_DIMENSION     16384
+#define DDS_MAX_MIPMAP_LEVELS 15
+
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t format;
+  uint64_t source_hash;
+  int32_t width;
+  int32_t height;
+  uint64_t data_size;
+} TextureCacheHeader;
+
+static bool texture_load_from_cache(Texture* texture, const char* cache_path, TextureFormat format, uint64_t hash);
+static void texture_write_cache(const Texture* texture, const char* cache_path, uint64_t hash);
+static void texture_repack_rgba(Color* dest, const unsigned char* rgba, size_t num_texels);
+static size_t texture_block_size(TextureFormat format);
+static Color texture_block_texel_at(const Texture* texture, int x, int y);
+static bool has_extension(const char* path, const char* extension);
+static uint32_t read_u32_le(const unsigned char* bytes);
+
 Texture* texture_make(void)
 {
   Texture* texture = malloc(sizeof(Texture));
   texture->width = texture->height = 0;
+  texture->format = TEXTURE_FORMAT_RGBA;
   texture->data = NULL;
+  texture->blocks = NULL;
+  texture->id = 0;
+  texture->mapping = mapped_file_make();
   return texture;
 }
 
 bool texture_load_from_file(Texture* texture, const char* path)
 {
+  if (has_extension(path, ".dds")) {
+    return texture_load_from_dds(texture, path);
+  }
+
   int width, height;
   unsigned char* image_data = stbi_load(path, &width, &height, NULL, 4);
   if (image_data == NULL) {
@@ -22,29 +86,197 @@ bool texture_load_from_file(Texture* texture, const char* path)
 
   texture->width = width;
   texture->height = height;
+  texture->format = TEXTURE_FORMAT_RGBA;
   texture->data = malloc(width * height * sizeof(Color));
+  texture_repack_rgba(texture->data, image_data, (size_t)width * height);
+
+  stbi_image_free(image_data);
+  return true;
+}
+
+// Only the top mip level of DXT1/DXT5 surfaces is read, but the file has to hold every level its header declares.
+bool texture_load_from_dds(Texture* texture, const char* path)
+{
+  FILE* input = fopen(path, "rb");
+  if (input == NULL) {
+    fprintf(stderr, "Failed to open texture file: %s\n", path);
+    return false;
+  }
+
+  unsigned char header[DDS_HEADER_SIZE];
+  if (fread(header, 1, sizeof(header), input) != sizeof(header) || memcmp(header, "DDS ", 4) != 0) {
+    fprintf(stderr, "Not a DDS file: %s\n", path);
+    fclose(input);
+    return false;
+  }
 
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-      unsigned char* rgba = &image_data[x * 4 + y * width * 4];
-      texture->data[x + y * width] = (rgba[0] << 24) | (rgba[1] << 16) | (rgba[2] << 8) | rgba[3];
+  TextureFormat format;
+  if (memcmp(&header[84], "DXT1", 4) == 0) {
+    format = TEXTURE_FORMAT_BC1;
+  } else if (memcmp(&header[84], "DXT5", 4) == 0) {
+    format = TEXTURE_FORMAT_BC3;
+  } else {
+    fprintf(stderr, "Unsupported DDS pixel format: %s\n", path);
+    fclose(input);
+    return false;
+  }
+
+  const uint32_t height = read_u32_le(&header[12]);
+  const uint32_t width = read_u32_le(&header[16]);
+  const uint32_t num_levels = read_u32_le(&header[28]) > 0 ? read_u32_le(&header[28]) : 1;
+  if (width == 0 || height == 0 || width > DDS_MAX_DIMENSION || height > DDS_MAX_DIMENSION ||
+      num_levels > DDS_MAX_MIPMAP_LEVELS) {
+    fprintf(stderr, "Invalid DDS dimensions: %s\n", path);
+    fclose(input);
+    return false;
+  }
+
+  const size_t num_bytes = (size_t)((width + 3) / 4) * ((height + 3) / 4) * texture_block_size(format);
+  size_t payload_size = 0;
+  for (uint32_t level = 0; level < num_levels; level++) {
+    const uint32_t level_width = width >> level > 0 ? width >> level : 1;
+    const uint32_t level_height = height >> level > 0 ? height >> level : 1;
+    payload_size += (size_t)((level_width + 3) / 4) * ((level_height + 3) / 4) * texture_block_size(format);
+  }
+
+  long file_size = -1;
+  if (fseek(input, 0, SEEK_END) == 0) file_size = ftell(input);
+  if (file_size < 0 || (size_t)file_size - DDS_HEADER_SIZE < payload_size ||
+      fseek(input, DDS_HEADER_SIZE, SEEK_SET) != 0) {
+    fprintf(stderr, "Truncated DDS file: %s\n", path);
+    fclose(input);
+    return false;
+  }
+
+  unsigned char* blocks = malloc(num_bytes);
+  if (blocks == NULL || fread(blocks, 1, num_bytes, input) != num_bytes) {
+    fprintf(stderr, "Truncated DDS file: %s\n", path);
+    free(blocks);
+    fclose(input);
+    return false;
+  }
+  fclose(input);
+
+  texture->width = width;
+  texture->height = height;
+  texture->format = format;
+  texture->blocks = blocks;
+  texture->id = atomic_fetch_add(&next_texture_id, 1);
+  return true;
+}
+
+// Loads the texture in the given format, going through its cache file if that is up to date. Otherwise the texture is
+// decoded (and compressed) as usual and the cache file is rewritten.
+bool texture_load_cached(Texture* texture, const char* path, TextureFormat format)
+{
+  MappedFile source = mapped_file_make();
+  if (!mapped_file_open(&source, path)) {
+    fprintf(stderr, "Failed to open texture file: %s\n", path);
+    return false;
+  }
+  const uint64_t hash = hash_bytes(source.data, source.size);
+  mapped_file_close(&source);
+
+  char* cache_path = malloc(strlen(path) + strlen(TEXTURE_CACHE_EXTENSION) + 1);
+  strcpy(cache_path, path);
+  strcat(cache_path, TEXTURE_CACHE_EXTENSION);
+
+  bool loaded = texture_load_from_cache(texture, cache_path, format, hash);
+  if (!loaded) {
+    loaded = texture_load_from_file(texture, path);
+    if (loaded && texture->format != format) {
+      loaded = texture_compress(texture, format);
+      if (!loaded) fprintf(stderr, "Failed to convert texture: %s\n", path);
+    }
+    if (loaded) {
+      texture_write_cache(texture, cache_path, hash);
     }
   }
 
-  stbi_image_free(image_data);
+  free(cache_path);
+  return loaded;
+}
+
+// Fails for textures that are already compressed, which can't be converted to anything else.
+bool texture_compress(Texture* texture, TextureFormat format)
+{
+  if (texture->format != TEXTURE_FORMAT_RGBA) {
+    fprintf(stderr, "Texture is already compressed\n");
+    return false;
+  }
+  if (format == TEXTURE_FORMAT_RGBA) {
+    fprintf(stderr, "Texture can't be compressed to RGBA\n");
+    return false;
+  }
+
+  const int blocks_x = (texture->width + 3) / 4;
+  const int blocks_y = (texture->height + 3) / 4;
+  const size_t block_size = texture_block_size(format);
+  unsigned char* blocks = malloc((size_t)blocks_x * blocks_y * block_size);
+
+  for (int by = 0; by < blocks_y; by++) {
+    for (int bx = 0; bx < blocks_x; bx++) {
+      // Texels past the edge of the texture repeat the last row/column.
+      Color texels[BLOCK_NUM_TEXELS];
+      for (int y = 0; y < BLOCK_DIMENSION; y++) {
+        for (int x = 0; x < BLOCK_DIMENSION; x++) {
+          const int tx = fmin(bx * BLOCK_DIMENSION + x, texture->width - 1);
+          const int ty = fmin(by * BLOCK_DIMENSION + y, texture->height - 1);
+          texels[x + y * BLOCK_DIMENSION] = texture->data[tx + ty * texture->width];
+        }
+      }
+
+      unsigned char* block = &blocks[(bx + (size_t)by * blocks_x) * block_size];
+      if (format == TEXTURE_FORMAT_BC1) {
+        bc1_encode_block(texels, block);
+      } else {
+        bc3_encode_block(texels, block);
+      }
+    }
+  }
+
+  if (mapped_file_is_open(&texture->mapping)) {
+    mapped_file_close(&texture->mapping);
+  } else {
+    free(texture->data);
+  }
+  texture->data = NULL;
+  texture->blocks = blocks;
+  texture->format = format;
+  texture->id = atomic_fetch_add(&next_texture_id, 1);
   return true;
 }
 
 void texture_destroy(Texture* texture)
 {
-  free(texture->data);
+  if (mapped_file_is_open(&texture->mapping)) {
+    mapped_file_close(&texture->mapping);
+  } else {
+    free(texture->data);
+    free(texture->blocks);
+  }
   free(texture);
 }
 
+size_t texture_size_in_bytes(const Texture* texture)
+{
+  if (texture->format == TEXTURE_FORMAT_RGBA) {
+    return (size_t)texture->width * texture->height * sizeof(Color);
+  }
+
+  const size_t num_blocks = (size_t)((texture->width + 3) / 4) * ((texture->height + 3) / 4);
+  return num_blocks * texture_block_size(texture->format);
+}
+
 Color texture_at(const Texture* texture, int x, int y)
 {
   assert(x >= 0 && x < texture->width);
   assert(y >= 0 && y < texture->height);
+
+  if (texture->format != TEXTURE_FORMAT_RGBA) {
+    return texture_block_texel_at(texture, x, y);
+  }
+
   return texture->data[x + y * texture->width];
 }
 
@@ -54,3 +286,140 @@ Color texture_uv_at(const Texture* texture, float u, float v)
   assert(v >= 0.0f && v <= 1.0f);
   return texture_at(texture, u * (texture->width - 1), v * (texture->height - 1));
 }
+
+static bool texture_load_from_cache(Texture* texture, const char* cache_path, TextureFormat format, uint64_t hash)
+{
+  MappedFile cache = mapped_file_make();
+  if (!mapped_file_open(&cache, cache_path)) return false;
+
+  const TextureCacheHeader* header = (const TextureCacheHeader*)cache.data;
+  const bool valid = cache.size >= sizeof(TextureCacheHeader) &&
+                     memcmp(header->magic, TEXTURE_CACHE_MAGIC, sizeof(header->magic)) == 0 &&
+                     header->version == TEXTURE_CACHE_VERSION && header->format == (uint32_t)format &&
+                     header->source_hash == hash && header->width > 0 && header->height > 0 &&
+                     cache.size - sizeof(TextureCacheHeader) >= header->data_size;
+  if (!valid) {
+    mapped_file_close(&cache);
+    return false;
+  }
+
+  texture->width = header->width;
+  texture->height = header->height;
+  texture->format = format;
+  if (texture_size_in_bytes(texture) != header->data_size) {
+    mapped_file_close(&cache);
+    return false;
+  }
+
+  unsigned char* data = cache.data + sizeof(TextureCacheHeader);
+  if (format == TEXTURE_FORMAT_RGBA) {
+    texture->data = (Color*)data;
+  } else {
+    texture->blocks = data;
+  }
+  texture->id = atomic_fetch_add(&next_texture_id, 1);
+  texture->mapping = cache;
+  return true;
+}
+
+// Failing to write the cache isn't an error, the texture is simply converted again next time.
+static void texture_write_cache(const Texture* texture, const char* cache_path, uint64_t hash)
+{
+  TextureCacheHeader header = {
+    .version = TEXTURE_CACHE_VERSION,
+    .format = texture->format,
+    .source_hash = hash,
+    .width = texture->width,
+    .height = texture->height,
+    .data_size = texture_size_in_bytes(texture),
+  };
+  memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(header.magic));
+
+  // Write to a temporary file first, so that a partially written cache is never picked up.
+  char* temp_path = malloc(strlen(cache_path) + 5);
+  strcpy(temp_path, cache_path);
+  strcat(temp_path, ".tmp");
+
+  FILE* output = fopen(temp_path, "wb");
+  if (output == NULL) {
+    free(temp_path);
+    return;
+  }
+
+  const void* data = texture->format == TEXTURE_FORMAT_RGBA ? (const void*)texture->data : texture->blocks;
+  const bool written = fwrite(&header, sizeof(header), 1, output) == 1 &&
+                       fwrite(data, 1, header.data_size, output) == header.data_size;
+  if (fclose(output) == 0 && written) {
+    rename(temp_path, cache_path);
+  } else {
+    remove(temp_path);
+  }
+
+  free(temp_path);
+}
+
+// `Color` keeps red in the most significant byte, so on little endian machines each texel is the byte reversal of
+// stb's RGBA quadruple.
+static void texture_repack_rgba(Color* dest, const unsigned char* rgba, size_t num_texels)
+{
+  size_t i = 0;
+
+#if defined(__SSSE3__)
+  const __m128i shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  for (; i + 4 <= num_texels; i += 4) {
+    const __m128i texels = _mm_loadu_si128((const __m128i*)&rgba[4 * i]);
+    _mm_storeu_si128((__m128i*)&dest[i], _mm_shuffle_epi8(texels, shuffle));
+  }
+#endif
+
+  for (; i < num_texels; i++) {
+    const unsigned char* texel = &rgba[4 * i];
+    dest[i] = ((Color)texel[0] << 24) | ((Color)texel[1] << 16) | ((Color)texel[2] << 8) | texel[3];
+  }
+}
+
+static size_t texture_block_size(TextureFormat format)
+{
+  switch (format) {
+    case TEXTURE_FORMAT_BC1:
+      return BC1_BLOCK_SIZE;
+    case TEXTURE_FORMAT_BC3:
+      return BC3_BLOCK_SIZE;
+    default:
+      assert(false);
+      return 0;
+  }
+}
+
+static Color texture_block_texel_at(const Texture* texture, int x, int y)
+{
+  const int block_x = x / BLOCK_DIMENSION;
+  const int block_y = y / BLOCK_DIMENSION;
+  const size_t block_index = block_x + (size_t)block_y * ((texture->width + 3) / 4);
+
+  CachedBlock* cached = &block_cache[(block_y & 7) * 8 + (block_x & 7)];
+  if (cached->texture_id != texture->id || cached->block_index != block_index) {
+    const unsigned char* block = &texture->blocks[block_index * texture_block_size(texture->format)];
+    if (texture->format == TEXTURE_FORMAT_BC1) {
+      bc1_decode_block(block, cached->texels);
+    } else {
+      bc3_decode_block(block, cached->texels);
+    }
+    cached->texture_id = texture->id;
+    cached->block_index = block_index;
+  }
+
+  return cached->texels[(x % BLOCK_DIMENSION) + (y % BLOCK_DIMENSION) * BLOCK_DIMENSION];
+}
+
+static bool has_extension(const char* path, const char* extension)
+{
+  const size_t path_length = strlen(path);
+  const size_t extension_length = strlen(extension);
+  return path_length >= extension_length && strcmp(&path[path_length - extension_length], extension) == 0;
+}
+
+static uint32_t read_u32_le(const unsigned char* bytes)
+{
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
@@ -2,19 +2,35 @@
 #define TEXTURE_H_
 
 #include "graphics.h"
+#include "mapped_file.h"
 
 #include <stdbool.h>
+#include <stddef.h>
+
+typedef enum {
+  TEXTURE_FORMAT_RGBA,
+  TEXTURE_FORMAT_BC1,  // 4x4 blocks of 8 bytes, 1-bit alpha
+  TEXTURE_FORMAT_BC3,  // 4x4 blocks of 16 bytes, interpolated alpha
+} TextureFormat;
 
 typedef struct
 {
   int width;
   int height;
-  Color* data;
+  TextureFormat format;
+  Color* data;            // Only used by `TEXTURE_FORMAT_RGBA`
+  unsigned char* blocks;  // Only used by the block-compressed formats
+  unsigned int id;        // Identifies the texture in the decoded-block cache
+  MappedFile mapping;     // Holds `data`/`blocks` when the texture was loaded from its cache file
 } Texture;
 
 Texture* texture_make(void);
 bool texture_load_from_file(Texture* texture, const char* path);
+bool texture_load_from_dds(Texture* texture, const char* path);
+bool texture_load_cached(Texture* texture, const char* path, TextureFormat format);
+bool texture_compress(Texture* texture, TextureFormat format);
 void texture_destroy(Texture* texture);
+size_t texture_size_in_bytes(const Texture* texture);
 Color texture_at(const Texture* texture, int x, int y);
 Color texture_uv_at(const Texture* texture, float u, float v);
 
@@ -0,0 +1,263 @@
+#define _POSIX_C_SOURCE 200809L  // strdup
+
+#include "texture_manager.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define PLACEHOLDER_MAX_DIMENSION 16
+
+static void* texture_manager_worker(void* arg);
+static void texture_manager_enqueue(TextureManager* manager, size_t handle);
+static Texture* texture_make_placeholder(const Texture* source);
+static Texture* texture_make_solid(Color color);
+
+// Runs with as many of the `num_workers` worker threads as can be started. Returns NULL if none can.
+TextureManager* texture_manager_make(size_t num_workers, TextureFormat format, size_t memory_budget)
+{
+  assert(num_workers > 0);
+
+  TextureManager* manager = malloc(sizeof(TextureManager));
+  pthread_mutex_init(&manager->mutex, NULL);
+  pthread_cond_init(&manager->work_available, NULL);
+  manager->textures = dyn_list_make(sizeof(ManagedTexture));
+  manager->queue = dyn_list_make(sizeof(size_t));
+  manager->queue_head = 0;
+  manager->default_placeholder = texture_make_solid(0x808080ff);
+  manager->retired = dyn_list_make(sizeof(Texture*));
+  manager->format = format;
+  manager->memory_budget = memory_budget;
+  manager->memory_used = 0;
+  manager->frame = 0;
+  manager->shutting_down = false;
+
+  manager->workers = malloc(num_workers * sizeof(pthread_t));
+  manager->num_workers = 0;
+  for (size_t i = 0; i < num_workers; i++) {
+    if (pthread_create(&manager->workers[manager->num_workers], NULL, texture_manager_worker, manager) != 0) break;
+    manager->num_workers++;
+  }
+  if (manager->num_workers == 0) {
+    fprintf(stderr, "Failed to start texture workers\n");
+    texture_manager_destroy(manager);
+    return NULL;
+  }
+
+  return manager;
+}
+
+void texture_manager_destroy(TextureManager* manager)
+{
+  pthread_mutex_lock(&manager->mutex);
+  manager->shutting_down = true;
+  pthread_cond_broadcast(&manager->work_available);
+  pthread_mutex_unlock(&manager->mutex);
+
+  for (size_t i = 0; i < manager->num_workers; i++) {
+    pthread_join(manager->workers[i], NULL);
+  }
+  free(manager->workers);
+
+  for (size_t i = 0; i < manager->textures.size; i++) {
+    ManagedTexture* entry = dyn_list_mutable_at(&manager->textures, i);
+    free(entry->path);
+    if (entry->texture != NULL) texture_destroy(entry->texture);
+    if (entry->placeholder != manager->default_placeholder) texture_destroy(entry->placeholder);
+  }
+  for (size_t i = 0; i < manager->retired.size; i++) {
+    texture_destroy(*(Texture* const*)dyn_list_at(&manager->retired, i));
+  }
+  dyn_list_destroy(&manager->textures);
+  dyn_list_destroy(&manager->queue);
+  dyn_list_destroy(&manager->retired);
+  texture_destroy(manager->default_placeholder);
+
+  pthread_cond_destroy(&manager->work_available);
+  pthread_mutex_destroy(&manager->mutex);
+  free(manager);
+}
+
+// Returns a handle to pass to `texture_manager_get`. Decoding starts in the background right away.
+size_t texture_manager_request(TextureManager* manager, const char* path)
+{
+  pthread_mutex_lock(&manager->mutex);
+
+  const ManagedTexture entry = {
+    .path = strdup(path),
+    .texture = NULL,
+    .placeholder = manager->default_placeholder,
+    .state = TEXTURE_STATE_QUEUED,
+    .last_used_frame = manager->frame,
+  };
+  dyn_list_add(&manager->textures, &entry);
+
+  const size_t handle = manager->textures.size - 1;
+  texture_manager_enqueue(manager, handle);
+
+  pthread_mutex_unlock(&manager->mutex);
+  return handle;
+}
+
+// Marks the texture as used this frame and returns whatever version of it is currently resident. The returned texture
+// stays valid until the next call to `texture_manager_end_frame`.
+const Texture* texture_manager_get(TextureManager* manager, size_t handle)
+{
+  pthread_mutex_lock(&manager->mutex);
+
+  ManagedTexture* entry = dyn_list_mutable_at(&manager->textures, handle);
+  entry->last_used_frame = manager->frame;
+
+  if (entry->state == TEXTURE_STATE_EVICTED) {
+    entry->state = TEXTURE_STATE_QUEUED;
+    texture_manager_enqueue(manager, handle);
+  }
+
+  const Texture* texture = entry->state == TEXTURE_STATE_RESIDENT ? entry->texture : entry->placeholder;
+
+  pthread_mutex_unlock(&manager->mutex);
+  return texture;
+}
+
+TextureState texture_manager_state(TextureManager* manager, size_t handle)
+{
+  pthread_mutex_lock(&manager->mutex);
+  const ManagedTexture* entry = dyn_list_at(&manager->textures, handle);
+  const TextureState state = entry->state;
+  pthread_mutex_unlock(&manager->mutex);
+  return state;
+}
+
+// Evicts least recently used textures until the budget is met. Textures used during the current frame are never
+// evicted, so the budget may be exceeded temporarily. Placeholders replaced during the frame are freed here too.
+void texture_manager_end_frame(TextureManager* manager)
+{
+  pthread_mutex_lock(&manager->mutex);
+
+  for (size_t i = 0; i < manager->retired.size; i++) {
+    texture_destroy(*(Texture* const*)dyn_list_at(&manager->retired, i));
+  }
+  manager->retired.size = 0;
+
+  while (manager->memory_used > manager->memory_budget) {
+    ManagedTexture* victim = NULL;
+    for (size_t i = 0; i < manager->textures.size; i++) {
+      ManagedTexture* entry = dyn_list_mutable_at(&manager->textures, i);
+      if (entry->state != TEXTURE_STATE_RESIDENT || entry->last_used_frame >= manager->frame) continue;
+      if (victim == NULL || entry->last_used_frame < victim->last_used_frame) victim = entry;
+    }
+    if (victim == NULL) break;
+
+    manager->memory_used -= texture_size_in_bytes(victim->texture);
+    texture_destroy(victim->texture);
+    victim->texture = NULL;
+    victim->state = TEXTURE_STATE_EVICTED;
+  }
+
+  manager->frame++;
+
+  pthread_mutex_unlock(&manager->mutex);
+}
+
+static void* texture_manager_worker(void* arg)
+{
+  TextureManager* manager = arg;
+
+  pthread_mutex_lock(&manager->mutex);
+
+  while (true) {
+    while (!manager->shutting_down && manager->queue_head == manager->queue.size) {
+      pthread_cond_wait(&manager->work_available, &manager->mutex);
+    }
+    if (manager->shutting_down) break;
+
+    const size_t handle = *(const size_t*)dyn_list_at(&manager->queue, manager->queue_head);
+    manager->queue_head++;
+    if (manager->queue_head == manager->queue.size) {
+      manager->queue_head = manager->queue.size = 0;
+    }
+
+    ManagedTexture* entry = dyn_list_mutable_at(&manager->textures, handle);
+    entry->state = TEXTURE_STATE_LOADING;
+    char* path = strdup(entry->path);
+
+    // Decode without holding the lock. The entry may move in the meantime, so it's looked up again afterwards.
+    pthread_mutex_unlock(&manager->mutex);
+    Texture* texture = texture_make();
+    const bool loaded = texture_load_cached(texture, path, manager->format);
+    Texture* placeholder = loaded ? texture_make_placeholder(texture) : NULL;
+    pthread_mutex_lock(&manager->mutex);
+
+    entry = dyn_list_mutable_at(&manager->textures, handle);
+    if (loaded) {
+      if (entry->placeholder != manager->default_placeholder) dyn_list_add(&manager->retired, &entry->placeholder);
+      entry->placeholder = placeholder;
+      entry->texture = texture;
+      entry->state = TEXTURE_STATE_RESIDENT;
+      manager->memory_used += texture_size_in_bytes(texture);
+    } else {
+      fprintf(stderr, "Failed to load texture: %s\n", path);
+      texture_destroy(texture);
+      entry->state = TEXTURE_STATE_FAILED;
+    }
+    free(path);
+  }
+
+  pthread_mutex_unlock(&manager->mutex);
+  return NULL;
+}
+
+// Must be called with the mutex held.
+static void texture_manager_enqueue(TextureManager* manager, size_t handle)
+{
+  dyn_list_add(&manager->queue, &handle);
+  pthread_cond_signal(&manager->work_available);
+}
+
+// Box-filters `source` down so that neither side exceeds `PLACEHOLDER_MAX_DIMENSION` texels.
+static Texture* texture_make_placeholder(const Texture* source)
+{
+  const int step_x = (source->width + PLACEHOLDER_MAX_DIMENSION - 1) / PLACEHOLDER_MAX_DIMENSION;
+  const int step_y = (source->height + PLACEHOLDER_MAX_DIMENSION - 1) / PLACEHOLDER_MAX_DIMENSION;
+  const int step = step_x > step_y ? step_x : step_y;
+
+  Texture* placeholder = texture_make();
+  placeholder->width = (source->width + step - 1) / step;
+  placeholder->height = (source->height + step - 1) / step;
+  placeholder->data = malloc(placeholder->width * placeholder->height * sizeof(Color));
+
+  for (int y = 0; y < placeholder->height; y++) {
+    for (int x = 0; x < placeholder->width; x++) {
+      unsigned int sums[4] = { 0, 0, 0, 0 };
+      unsigned int count = 0;
+
+      for (int sy = y * step; sy < (y + 1) * step && sy < source->height; sy++) {
+        for (int sx = x * step; sx < (x + 1) * step && sx < source->width; sx++) {
+          const Color texel = texture_at(source, sx, sy);
+          for (int c = 0; c < 4; c++) {
+            sums[c] += (texel >> (24 - 8 * c)) & 0xff;
+          }
+          count++;
+        }
+      }
+
+      Color average = 0;
+      for (int c = 0; c < 4; c++) {
+        average |= (Color)(sums[c] / count) << (24 - 8 * c);
+      }
+      placeholder->data[x + y * placeholder->width] = average;
+    }
+  }
+
+  return placeholder;
+}
+
+static Texture* texture_make_solid(Color color)
+{
+  Texture* texture = texture_make();
+  texture->width = texture->height = 1;
+  texture->data = malloc(sizeof(Color));
+  texture->data[0] = color;
+  return texture;
+}
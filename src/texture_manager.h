@@ -0,0 +1,57 @@
+#ifndef TEXTURE_MANAGER_H_
+#define TEXTURE_MANAGER_H_
+
+#include "texture.h"
+#include "dynlist.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum {
+  TEXTURE_STATE_QUEUED,
+  TEXTURE_STATE_LOADING,
+  TEXTURE_STATE_RESIDENT,
+  TEXTURE_STATE_EVICTED,
+  TEXTURE_STATE_FAILED,
+} TextureState;
+
+typedef struct
+{
+  char* path;
+  Texture* texture;      // Full resolution texture; only set while resident
+  Texture* placeholder;  // Low resolution stand-in, used until (and after) the full texture is resident
+  TextureState state;
+  unsigned long last_used_frame;
+} ManagedTexture;
+
+// Decodes textures on worker threads, converting them to `format` through the texture cache. Until a texture is
+// resident, `texture_manager_get` hands out a low resolution placeholder instead. At the end of each frame the least
+// recently used textures are evicted until the resident textures fit in the memory budget; their placeholders stay
+// behind and they are reloaded the next time they're used.
+typedef struct
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t work_available;
+  pthread_t* workers;
+  size_t num_workers;  // That were started
+  DynList textures;  // ManagedTexture
+  DynList queue;     // Handles waiting to be decoded
+  size_t queue_head;
+  Texture* default_placeholder;
+  DynList retired;       // Texture*, replaced placeholders that `texture_manager_get` may still have handed out
+  TextureFormat format;
+  size_t memory_budget;  // In bytes, only counting full resolution textures
+  size_t memory_used;
+  unsigned long frame;
+  bool shutting_down;
+} TextureManager;
+
+TextureManager* texture_manager_make(size_t num_workers, TextureFormat format, size_t memory_budget);
+void texture_manager_destroy(TextureManager* manager);
+size_t texture_manager_request(TextureManager* manager, const char* path);
+const Texture* texture_manager_get(TextureManager* manager, size_t handle);
+TextureState texture_manager_state(TextureManager* manager, size_t handle);
+void texture_manager_end_frame(TextureManager* manager);
+
+#endif
@@ -0,0 +1,182 @@
+#include "triangle_strips.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define NO_TRIANGLE SIZE_MAX
+
+typedef struct
+{
+  const size_t* indices;
+  const size_t* offsets;    // Of each vertex's triangles in `adjacency`
+  const size_t* adjacency;  // Triangles using each vertex
+  const bool* emitted;
+  size_t group_begin;
+  size_t group_end;
+} StripContext;
+
+static size_t find_triangle(const StripContext* context, size_t from, size_t to, size_t* third);
+static size_t count_neighbors(const StripContext* context, size_t triangle);
+static size_t strip_length(const StripContext* context, size_t p, size_t q);
+
+// Strips are grown greedily: each one starts at the triangle of the group with the fewest neighbors not yet in a strip,
+// which keeps the strips from leaving isolated triangles behind. Which edge it continues across decides every later
+// triangle of the strip, so it is turned to whichever direction gives the longest strip.
+size_t triangle_strips_build(size_t output[],
+                             size_t group_offsets[],
+                             const size_t indices[],
+                             size_t num_indices,
+                             const size_t group_ends[],
+                             size_t num_groups,
+                             size_t num_vertices,
+                             size_t restart)
+{
+  const size_t num_triangles = num_indices / 3;
+
+  size_t* offsets = calloc(num_vertices + 1, sizeof(size_t));
+  for (size_t i = 0; i < num_indices; i++) {
+    offsets[indices[i] + 1]++;
+  }
+  for (size_t i = 0; i < num_vertices; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+
+  size_t* adjacency = malloc(num_indices * sizeof(size_t));
+  size_t* filled = calloc(num_vertices, sizeof(size_t));
+  for (size_t i = 0; i < num_indices; i++) {
+    adjacency[offsets[indices[i]] + filled[indices[i]]++] = i / 3;
+  }
+  free(filled);
+
+  bool* emitted = calloc(num_triangles, sizeof(bool));
+  StripContext context = {
+    .indices = indices,
+    .offsets = offsets,
+    .adjacency = adjacency,
+    .emitted = emitted,
+  };
+
+  size_t size = 0;
+  for (size_t g = 0; g < num_groups; g++) {
+    context.group_begin = g == 0 ? 0 : group_ends[g - 1];
+    context.group_end = group_ends[g];
+    group_offsets[g] = size;
+
+    size_t next_unemitted = context.group_begin;
+    for (;;) {
+      while (next_unemitted < context.group_end && emitted[next_unemitted]) next_unemitted++;
+      if (next_unemitted == context.group_end) break;
+
+      size_t start = next_unemitted;
+      size_t fewest_neighbors = SIZE_MAX;
+      for (size_t t = next_unemitted; t < context.group_end && fewest_neighbors > 1; t++) {
+        if (emitted[t]) continue;
+        const size_t neighbors = count_neighbors(&context, t);
+        if (neighbors < fewest_neighbors) {
+          fewest_neighbors = neighbors;
+          start = t;
+        }
+      }
+      emitted[start] = true;
+
+      const size_t* corners = &indices[3 * start];
+      size_t rotation = 0;
+      size_t longest = 0;
+      for (size_t r = 0; r < 3; r++) {
+        const size_t length = strip_length(&context, corners[(r + 1) % 3], corners[(r + 2) % 3]);
+        if (length > longest) {
+          longest = length;
+          rotation = r;
+        }
+      }
+
+      if (size > 0) output[size++] = restart;
+      size_t o = corners[rotation];
+      size_t p = corners[(rotation + 1) % 3];
+      size_t q = corners[(rotation + 2) % 3];
+      output[size++] = o;
+      output[size++] = p;
+      output[size++] = q;
+
+      // The next triangle of the strip must use the edge between its last two vertices in the opposite direction of
+      // the previous triangle. If there is none, the strip can still turn around its last vertex and continue across
+      // the previous triangle's other edge, by repeating the vertex before last: the resulting degenerate triangle
+      // costs one index, where starting a new strip costs three.
+      for (size_t n = 1;; n++) {
+        size_t r;
+        size_t next = n % 2 == 0 ? find_triangle(&context, p, q, &r) : find_triangle(&context, q, p, &r);
+        if (next != NO_TRIANGLE) {
+          o = p;
+        } else {
+          next = n % 2 == 1 ? find_triangle(&context, o, q, &r) : find_triangle(&context, q, o, &r);
+          if (next == NO_TRIANGLE) break;
+
+          output[size - 1] = o;
+          output[size++] = q;
+          n++;
+        }
+
+        emitted[next] = true;
+        output[size++] = r;
+        p = q;
+        q = r;
+      }
+    }
+  }
+  group_offsets[num_groups] = size;
+
+  free(offsets);
+  free(adjacency);
+  free(emitted);
+  return size;
+}
+
+// Returns a triangle of the group not yet in a strip that has the edge from `from` to `to`, and sets `third` to its
+// remaining vertex.
+static size_t find_triangle(const StripContext* context, size_t from, size_t to, size_t* third)
+{
+  for (size_t i = context->offsets[from]; i < context->offsets[from + 1]; i++) {
+    const size_t t = context->adjacency[i];
+    if (context->emitted[t] || t < context->group_begin || t >= context->group_end) continue;
+
+    const size_t* corners = &context->indices[3 * t];
+    for (size_t k = 0; k < 3; k++) {
+      if (corners[k] == from && corners[(k + 1) % 3] == to) {
+        *third = corners[(k + 2) % 3];
+        return t;
+      }
+    }
+  }
+  return NO_TRIANGLE;
+}
+
+static size_t count_neighbors(const StripContext* context, size_t triangle)
+{
+  const size_t* corners = &context->indices[3 * triangle];
+
+  size_t neighbors = 0;
+  for (size_t k = 0; k < 3; k++) {
+    size_t third;
+    neighbors += find_triangle(context, corners[(k + 1) % 3], corners[k], &third) != NO_TRIANGLE;
+  }
+  return neighbors;
+}
+
+// The number of triangles that a strip ending in `p`, `q` after an even number of triangles could be extended by.
+static size_t strip_length(const StripContext* context, size_t p, size_t q)
+{
+  const size_t max_length = context->group_end - context->group_begin;
+
+  size_t length = 0;
+  while (length < max_length) {
+    size_t r;
+    const size_t next = length % 2 == 0 ? find_triangle(context, q, p, &r) : find_triangle(context, p, q, &r);
+    if (next == NO_TRIANGLE) break;
+
+    p = q;
+    q = r;
+    length++;
+  }
+  return length;
+}
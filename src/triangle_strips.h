@@ -0,0 +1,25 @@
+#ifndef TRIANGLE_STRIPS_H_
+#define TRIANGLE_STRIPS_H_
+
+#include <stddef.h>
+
+// Rewrites a triangle list as strips, separated by `restart`, in which every index after the first two of a strip adds
+// a triangle. Every other triangle of a strip is wound the other way around, which whoever draws it undoes, so that all
+// triangles keep their original winding. Strips may also repeat a vertex to turn a corner, which adds a degenerate
+// triangle that should be skipped.
+//
+// Strips never join triangles of different groups, the consecutive runs of triangles that end before
+// `group_ends[i]`. The strips of group `i` are written to `output[group_offsets[i]]` up to
+// `output[group_offsets[i + 1]]`, possibly starting with a `restart`. `output` needs room for `4 * num_indices / 3`
+// indices and `group_offsets` for `num_groups + 1`. Returns the number of indices written. Starting each strip takes a
+// pass over the rest of its group, so groups should be small, such as meshlets.
+size_t triangle_strips_build(size_t output[],
+                             size_t group_offsets[],
+                             const size_t indices[],
+                             size_t num_indices,
+                             const size_t group_ends[],
+                             size_t num_groups,
+                             size_t num_vertices,
+                             size_t restart);
+
+#endif
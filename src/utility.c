@@ -18,3 +18,15 @@ char* strsep(char** stringp, const char* delim)
   }
   return token;
 }
+
+// 64-bit FNV-1a.
+uint64_t hash_bytes(const void* data, size_t size)
+{
+  const unsigned char* bytes = data;
+  uint64_t hash = 0xcbf29ce484222325;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
@@ -2,6 +2,8 @@
 #define UTILITY_H_
 
 #include <tgmath.h>
+#include <stddef.h>
+#include <stdint.h>
 
 // `M_PI` is not guaranteed to be defined by the C standard.
 #ifndef M_PI
@@ -25,5 +27,6 @@ static inline double wrap_angle(double angle)
 }
 
 char* strsep(char** stringp, const char* delim);
+uint64_t hash_bytes(const void* data, size_t size);
 
 #endif
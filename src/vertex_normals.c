@@ -0,0 +1,259 @@
+#include "vertex_normals.h"
+
+#include "index_buffer.h"
+#include "parallel.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <float.h>
+#include <tgmath.h>
+#include <assert.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+// Triangles, or vertices, handled by each parallel task.
+#define BATCH_SIZE 4096
+
+#define PI 3.14159265358979f
+
+typedef struct
+{
+  const unsigned char* positions;
+  unsigned char* normals;
+  size_t stride;
+  const DynList* indices;
+  VertexAdjacency* adjacency;
+} NormalsJob;
+
+static void vertex_normals_faces_task(void* context, size_t batch);
+static void vertex_normals_gather_task(void* context, size_t batch);
+static float approximate_acos(float x);
+
+VertexAdjacency vertex_adjacency_make(const DynList* indices, size_t num_vertices)
+{
+  assert(indices->size <= UINT32_MAX);
+
+  VertexAdjacency adjacency = {
+    .num_vertices = num_vertices,
+    .num_indices = indices->size,
+    .offsets = calloc(num_vertices + 1, sizeof(size_t)),
+    .corners = malloc(indices->size * sizeof(uint32_t)),
+    .faces = malloc(indices->size / 3 * sizeof(FaceNormal)),
+  };
+
+  for (size_t i = 0; i < indices->size; i++) {
+    adjacency.offsets[index_buffer_at(indices, i) + 1]++;
+  }
+  for (size_t i = 0; i < num_vertices; i++) {
+    adjacency.offsets[i + 1] += adjacency.offsets[i];
+  }
+
+  uint32_t* next = malloc(num_vertices * sizeof(uint32_t));
+  for (size_t i = 0; i < num_vertices; i++) {
+    next[i] = adjacency.offsets[i];
+  }
+  for (size_t i = 0; i < indices->size; i++) {
+    adjacency.corners[next[index_buffer_at(indices, i)]++] = i;
+  }
+  free(next);
+
+  return adjacency;
+}
+
+void vertex_adjacency_destroy(VertexAdjacency* adjacency)
+{
+  free(adjacency->offsets);
+  free(adjacency->corners);
+  free(adjacency->faces);
+}
+
+// First computes every triangle's unit normal and corner angles, and then sums the normals around each vertex, weighted
+// by the angles. Every output is written by exactly one task, so neither pass needs any synchronization, and the result
+// doesn't depend on the number of threads.
+void vertex_normals_compute(const unsigned char* positions,
+                            unsigned char* normals,
+                            size_t stride,
+                            const DynList* indices,
+                            VertexAdjacency* adjacency)
+{
+  NormalsJob job = {
+    .positions = positions,
+    .normals = normals,
+    .stride = stride,
+    .indices = indices,
+    .adjacency = adjacency,
+  };
+
+  const size_t num_triangles = adjacency->num_indices / 3;
+  parallel_for((num_triangles + BATCH_SIZE - 1) / BATCH_SIZE, vertex_normals_faces_task, &job);
+  parallel_for((adjacency->num_vertices + BATCH_SIZE - 1) / BATCH_SIZE, vertex_normals_gather_task, &job);
+}
+
+#if defined(__SSE__)
+typedef struct
+{
+  __m128 x;
+  __m128 y;
+  __m128 z;
+} Vec3x4;
+
+static inline Vec3x4 vec3x4_sub(const Vec3x4* v, const Vec3x4* w)
+{
+  return (Vec3x4){ _mm_sub_ps(v->x, w->x), _mm_sub_ps(v->y, w->y), _mm_sub_ps(v->z, w->z) };
+}
+
+static inline __m128 vec3x4_dot(const Vec3x4* v, const Vec3x4* w)
+{
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(v->x, w->x), _mm_mul_ps(v->y, w->y)), _mm_mul_ps(v->z, w->z));
+}
+
+static inline Vec3x4 vec3x4_cross(const Vec3x4* v, const Vec3x4* w)
+{
+  return (Vec3x4){
+    _mm_sub_ps(_mm_mul_ps(v->y, w->z), _mm_mul_ps(v->z, w->y)),
+    _mm_sub_ps(_mm_mul_ps(v->z, w->x), _mm_mul_ps(v->x, w->z)),
+    _mm_sub_ps(_mm_mul_ps(v->x, w->y), _mm_mul_ps(v->y, w->x)),
+  };
+}
+
+// Same approximation as `approximate_acos`, with the input clamped to [-1, 1] first.
+static inline __m128 approximate_acos4(__m128 x)
+{
+  x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+  const __m128 negative = _mm_cmplt_ps(x, _mm_setzero_ps());
+  const __m128 a = _mm_max_ps(x, _mm_sub_ps(_mm_setzero_ps(), x));
+
+  __m128 p = _mm_set1_ps(-0.0187293f);
+  p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(0.0742610f));
+  p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(-0.2121144f));
+  p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(1.5707288f));
+  const __m128 r = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), a)), p);
+
+  return _mm_or_ps(_mm_and_ps(negative, _mm_sub_ps(_mm_set1_ps(PI), r)), _mm_andnot_ps(negative, r));
+}
+
+static inline Vec3x4 load_positions4(const NormalsJob* job, size_t first_triangle, size_t corner)
+{
+  float x[4], y[4], z[4];
+  for (size_t j = 0; j < 4; j++) {
+    const size_t v = index_buffer_at(job->indices, 3 * (first_triangle + j) + corner);
+    const Vec3* p = (const Vec3*)&job->positions[v * job->stride];
+    x[j] = p->x;
+    y[j] = p->y;
+    z[j] = p->z;
+  }
+  return (Vec3x4){ _mm_loadu_ps(x), _mm_loadu_ps(y), _mm_loadu_ps(z) };
+}
+#endif
+
+static void vertex_normals_faces_task(void* context, size_t batch)
+{
+  NormalsJob* job = context;
+  FaceNormal* faces = job->adjacency->faces;
+
+  const size_t num_triangles = job->adjacency->num_indices / 3;
+  const size_t end = batch * BATCH_SIZE + BATCH_SIZE < num_triangles ? batch * BATCH_SIZE + BATCH_SIZE : num_triangles;
+  size_t t = batch * BATCH_SIZE;
+
+#if defined(__SSE__)
+  // Four triangles at a time, one per lane.
+  for (; t + 4 <= end; t += 4) {
+    const Vec3x4 p0 = load_positions4(job, t, 0);
+    const Vec3x4 p1 = load_positions4(job, t, 1);
+    const Vec3x4 p2 = load_positions4(job, t, 2);
+
+    const Vec3x4 e0 = vec3x4_sub(&p1, &p0);
+    const Vec3x4 e1 = vec3x4_sub(&p2, &p1);
+    const Vec3x4 e2 = vec3x4_sub(&p0, &p2);
+    const Vec3x4 n = vec3x4_cross(&e2, &e0);
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 n_length = _mm_sqrt_ps(vec3x4_dot(&n, &n));
+    const __m128 n_scale = _mm_and_ps(_mm_cmpgt_ps(n_length, zero), _mm_div_ps(_mm_set1_ps(1.0f), n_length));
+
+    const __m128 length_sq0 = vec3x4_dot(&e0, &e0);
+    const __m128 length_sq1 = vec3x4_dot(&e1, &e1);
+    const __m128 length_sq2 = vec3x4_dot(&e2, &e2);
+    const __m128 min = _mm_set1_ps(FLT_MIN);
+
+    __m128 cosines[3];
+    cosines[0] = _mm_div_ps(_mm_sub_ps(zero, vec3x4_dot(&e0, &e2)),
+                            _mm_sqrt_ps(_mm_max_ps(_mm_mul_ps(length_sq0, length_sq2), min)));
+    cosines[1] = _mm_div_ps(_mm_sub_ps(zero, vec3x4_dot(&e1, &e0)),
+                            _mm_sqrt_ps(_mm_max_ps(_mm_mul_ps(length_sq1, length_sq0), min)));
+    cosines[2] = _mm_div_ps(_mm_sub_ps(zero, vec3x4_dot(&e2, &e1)),
+                            _mm_sqrt_ps(_mm_max_ps(_mm_mul_ps(length_sq2, length_sq1), min)));
+
+    float x[4], y[4], z[4], angles[3][4];
+    _mm_storeu_ps(x, _mm_mul_ps(n.x, n_scale));
+    _mm_storeu_ps(y, _mm_mul_ps(n.y, n_scale));
+    _mm_storeu_ps(z, _mm_mul_ps(n.z, n_scale));
+    for (size_t k = 0; k < 3; k++) {
+      _mm_storeu_ps(angles[k], approximate_acos4(cosines[k]));
+    }
+    for (size_t j = 0; j < 4; j++) {
+      faces[t + j] = (FaceNormal){
+        .normal = vec3_make(x[j], y[j], z[j]),
+        .angles = { angles[0][j], angles[1][j], angles[2][j] },
+      };
+    }
+  }
+#endif
+
+  for (; t < end; t++) {
+    const Vec3* p0 = (const Vec3*)&job->positions[index_buffer_at(job->indices, 3 * t) * job->stride];
+    const Vec3* p1 = (const Vec3*)&job->positions[index_buffer_at(job->indices, 3 * t + 1) * job->stride];
+    const Vec3* p2 = (const Vec3*)&job->positions[index_buffer_at(job->indices, 3 * t + 2) * job->stride];
+
+    const Vec3 e0 = vec3_sub(p1, p0);
+    const Vec3 e1 = vec3_sub(p2, p1);
+    const Vec3 e2 = vec3_sub(p0, p2);
+    const Vec3 n = vec3_cross(&e2, &e0);
+
+    const float n_length = sqrt(vec3_dot(&n, &n));
+    const float n_scale = n_length > 0.0f ? 1.0f / n_length : 0.0f;
+
+    const float length_sq0 = vec3_dot(&e0, &e0);
+    const float length_sq1 = vec3_dot(&e1, &e1);
+    const float length_sq2 = vec3_dot(&e2, &e2);
+
+    faces[t].normal = vec3_mul(&n, n_scale);
+    faces[t].angles[0] = approximate_acos(-vec3_dot(&e0, &e2) / sqrt(fmax(length_sq0 * length_sq2, FLT_MIN)));
+    faces[t].angles[1] = approximate_acos(-vec3_dot(&e1, &e0) / sqrt(fmax(length_sq1 * length_sq0, FLT_MIN)));
+    faces[t].angles[2] = approximate_acos(-vec3_dot(&e2, &e1) / sqrt(fmax(length_sq2 * length_sq1, FLT_MIN)));
+  }
+}
+
+static void vertex_normals_gather_task(void* context, size_t batch)
+{
+  NormalsJob* job = context;
+  const VertexAdjacency* adjacency = job->adjacency;
+
+  const size_t start = batch * BATCH_SIZE;
+  const size_t end = start + BATCH_SIZE < adjacency->num_vertices ? start + BATCH_SIZE : adjacency->num_vertices;
+
+  for (size_t v = start; v < end; v++) {
+    Vec3 sum = vec3_make(0.0f, 0.0f, 0.0f);
+    for (size_t i = adjacency->offsets[v]; i < adjacency->offsets[v + 1]; i++) {
+      const uint32_t corner = adjacency->corners[i];
+      const FaceNormal* face = &adjacency->faces[corner / 3];
+      sum = vec3_mul_add(&sum, &face->normal, face->angles[corner % 3]);
+    }
+
+    const float length = vec3_length(&sum);
+    *(Vec3*)&job->normals[v * job->stride] = length > 0.0f ? vec3_mul(&sum, 1.0f / length) : sum;
+  }
+}
+
+// Abramowitz and Stegun 4.4.45, accurate to within 7e-5 radians, which is plenty for weighting normals. Inputs are
+// clamped to [-1, 1], since rounding can push the cosine of a very small or very large angle slightly outside it.
+static float approximate_acos(float x)
+{
+  x = fmin(fmax(x, -1.0f), 1.0f);
+  const float a = fabs(x);
+  const float p = ((-0.0187293f * a + 0.0742610f) * a - 0.2121144f) * a + 1.5707288f;
+  const float r = sqrt(1.0f - a) * p;
+  return x < 0.0f ? PI - r : r;
+}
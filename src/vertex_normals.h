@@ -0,0 +1,41 @@
+#ifndef VERTEX_NORMALS_H_
+#define VERTEX_NORMALS_H_
+
+#include "dynlist.h"
+#include "vector.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+  Vec3 normal;
+  float angles[3];  // At each corner, in radians
+} FaceNormal;
+
+// The triangle corners (positions in the index buffer) that use each vertex: those of vertex `v` are
+// `corners[offsets[v]]` up to `corners[offsets[v + 1]]`, in index buffer order. Only depends on the indices, so a
+// deforming mesh can build it once and reuse it every frame.
+typedef struct
+{
+  size_t num_vertices;
+  size_t num_indices;
+  size_t* offsets;
+  uint32_t* corners;
+  FaceNormal* faces;  // Scratch space for `vertex_normals_compute`
+} VertexAdjacency;
+
+VertexAdjacency vertex_adjacency_make(const DynList* indices, size_t num_vertices);
+void vertex_adjacency_destroy(VertexAdjacency* adjacency);
+
+// Sets every vertex normal to the unit length average of the normals of the triangles around it, each weighted by the
+// triangle's angle at the vertex. `positions` and `normals` point to the first vertex's position and normal, and
+// `stride` is the distance between consecutive vertices. Vertices without any non-degenerate triangle get a zero
+// normal.
+void vertex_normals_compute(const unsigned char* positions,
+                            unsigned char* normals,
+                            size_t stride,
+                            const DynList* indices,
+                            VertexAdjacency* adjacency);
+
+#endif
@@ -0,0 +1,138 @@
+#include "vertex_packing.h"
+
+#include <string.h>
+#include <tgmath.h>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+#define UNORM16_MAX 65535.0f
+#define SNORM16_MAX 32767.0f
+
+static float sign_not_zero(float x);
+
+PositionQuantization position_quantization_make(const Vec3* bounds_min, const Vec3* bounds_max)
+{
+  const Vec3 extent = vec3_sub(bounds_max, bounds_min);
+  const Vec3 scale = vec3_make(extent.x / UNORM16_MAX, extent.y / UNORM16_MAX, extent.z / UNORM16_MAX);
+
+  Mat4 dequantize = mat4_identity();
+  dequantize.elements[0][0] = scale.x;
+  dequantize.elements[1][1] = scale.y;
+  dequantize.elements[2][2] = scale.z;
+  dequantize.elements[0][3] = bounds_min->x;
+  dequantize.elements[1][3] = bounds_min->y;
+  dequantize.elements[2][3] = bounds_min->z;
+
+  return (PositionQuantization){
+    .offset = *bounds_min,
+    .scale = scale,
+    .dequantize = dequantize,
+  };
+}
+
+void position_quantize(const PositionQuantization* quantization, const Vec3* pos, uint16_t out[3])
+{
+  const Vec3 relative = vec3_sub(pos, &quantization->offset);
+  const float p[3] = { relative.x, relative.y, relative.z };
+  const float scale[3] = { quantization->scale.x, quantization->scale.y, quantization->scale.z };
+
+  for (size_t i = 0; i < 3; i++) {
+    // A flat box has a zero scale along that axis, where every position is at the offset.
+    const float q = scale[i] > 0.0f ? round(p[i] / scale[i]) : 0.0f;
+    out[i] = (uint16_t)fmin(fmax(q, 0.0f), UNORM16_MAX);
+  }
+}
+
+void normal_pack_octahedral(const Vec3* normal, int16_t out[2])
+{
+  const float length = fabs(normal->x) + fabs(normal->y) + fabs(normal->z);
+  if (length == 0.0f) {
+    out[0] = out[1] = 0;
+    return;
+  }
+
+  float u = normal->x / length;
+  float v = normal->y / length;
+  if (normal->z < 0.0f) {
+    // The lower half of the octahedron folds out over the corners of the square.
+    const float folded_u = (1.0f - fabs(v)) * sign_not_zero(u);
+    const float folded_v = (1.0f - fabs(u)) * sign_not_zero(v);
+    u = folded_u;
+    v = folded_v;
+  }
+
+  out[0] = (int16_t)round(fmin(fmax(u, -1.0f), 1.0f) * SNORM16_MAX);
+  out[1] = (int16_t)round(fmin(fmax(v, -1.0f), 1.0f) * SNORM16_MAX);
+}
+
+Vec3 normal_unpack_octahedral(const int16_t in[2])
+{
+  float u = fmax(in[0] * (1.0f / SNORM16_MAX), -1.0f);
+  float v = fmax(in[1] * (1.0f / SNORM16_MAX), -1.0f);
+  const float z = 1.0f - fabs(u) - fabs(v);
+  if (z < 0.0f) {
+    const float unfolded_u = (1.0f - fabs(v)) * sign_not_zero(u);
+    const float unfolded_v = (1.0f - fabs(u)) * sign_not_zero(v);
+    u = unfolded_u;
+    v = unfolded_v;
+  }
+
+  const Vec3 normal = vec3_make(u, v, z);
+  return vec3_normalized(&normal);
+}
+
+// Rounds to the nearest half, ties to even, like the hardware conversion.
+uint16_t half_from_float(float x)
+{
+#if defined(__F16C__)
+  return _cvtss_sh(x, _MM_FROUND_TO_NEAREST_INT);
+#else
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  const uint16_t sign = (bits >> 16) & 0x8000;
+  const uint32_t magnitude = bits & 0x7fffffff;
+
+  if (magnitude > 0x7f800000) return sign | 0x7e00;  // NaN
+  if (magnitude >= 0x477ff000) return sign | 0x7c00; // At least 65520, which rounds to infinity
+  if (magnitude < 0x38800000) {
+    // Below the smallest normal half, where the step is 2^-24.
+    float f;
+    memcpy(&f, &magnitude, sizeof(f));
+    return sign | (uint16_t)lrint(f * 16777216.0f);
+  }
+
+  // Rebiases the exponent from 127 to 15 and drops 13 bits of mantissa.
+  const uint32_t rounded = magnitude + 0xfff + ((magnitude >> 13) & 1);
+  return sign | (uint16_t)((rounded - 0x38000000) >> 13);
+#endif
+}
+
+float half_to_float(uint16_t x)
+{
+#if defined(__F16C__)
+  return _cvtsh_ss(x);
+#else
+  const uint32_t sign = (uint32_t)(x & 0x8000) << 16;
+  const uint32_t exponent = (x >> 10) & 0x1f;
+  const uint32_t mantissa = x & 0x3ff;
+
+  if (exponent == 0) {
+    const float f = mantissa / 16777216.0f;
+    return sign ? -f : f;
+  }
+
+  // Infinities and NaNs keep the largest exponent, everything else is rebiased from 15 to 127.
+  const uint32_t rebiased = exponent == 0x1f ? 0xff : exponent + 112;
+  const uint32_t bits = sign | rebiased << 23 | mantissa << 13;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+#endif
+}
+
+static float sign_not_zero(float x)
+{
+  return x >= 0.0f ? 1.0f : -1.0f;
+}
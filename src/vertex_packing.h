@@ -0,0 +1,29 @@
+#ifndef VERTEX_PACKING_H_
+#define VERTEX_PACKING_H_
+
+#include "matrix.h"
+#include "vector.h"
+
+#include <stdint.h>
+
+// Positions are stored as 16-bit fractions of the mesh's bounding box. `dequantize` maps them back to object space, so
+// multiplying it into the world matrix makes the decoding free.
+typedef struct
+{
+  Vec3 offset;
+  Vec3 scale;
+  Mat4 dequantize;
+} PositionQuantization;
+
+PositionQuantization position_quantization_make(const Vec3* bounds_min, const Vec3* bounds_max);
+void position_quantize(const PositionQuantization* quantization, const Vec3* pos, uint16_t out[3]);
+
+// Unit normals are folded onto an octahedron and stored as two signed 16-bit values, which is accurate to about 0.005
+// degrees. Zero normals come back as +Z.
+void normal_pack_octahedral(const Vec3* normal, int16_t out[2]);
+Vec3 normal_unpack_octahedral(const int16_t in[2]);
+
+uint16_t half_from_float(float x);
+float half_to_float(uint16_t x);
+
+#endif
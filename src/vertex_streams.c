@@ -0,0 +1,79 @@
+#include "vertex_streams.h"
+
+#include "vector.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define STREAM_ALIGNMENT 32
+
+VertexStreams vertex_streams_make(void)
+{
+  return (VertexStreams){ 0 };
+}
+
+void vertex_streams_destroy(VertexStreams* streams)
+{
+  free(streams->block);
+  *streams = vertex_streams_make();
+}
+
+void vertex_streams_build(VertexStreams* streams,
+                          const void* vertices,
+                          size_t num_vertices,
+                          size_t stride,
+                          size_t position_offset,
+                          size_t normal_offset,
+                          size_t uv_offset)
+{
+  vertex_streams_destroy(streams);
+
+  const bool has_normals = normal_offset != VERTEX_STREAM_ABSENT;
+  const bool has_uvs = uv_offset != VERTEX_STREAM_ABSENT;
+  const size_t num_streams = 3 + (has_normals ? 3 : 0) + (has_uvs ? 2 : 0);
+
+  // The padding lets vector code read whole registers past the last vertex.
+  const size_t floats_per_register = STREAM_ALIGNMENT / sizeof(float);
+  const size_t stream_length = (num_vertices + floats_per_register - 1) / floats_per_register * floats_per_register;
+  if (stream_length == 0) return;
+
+  float* block = aligned_alloc(STREAM_ALIGNMENT, num_streams * stream_length * sizeof(float));
+  memset(block, 0, num_streams * stream_length * sizeof(float));
+
+  streams->num_vertices = num_vertices;
+  streams->block = block;
+  streams->x = block;
+  streams->y = block + stream_length;
+  streams->z = block + 2 * stream_length;
+  float* next = block + 3 * stream_length;
+  if (has_normals) {
+    streams->nx = next;
+    streams->ny = next + stream_length;
+    streams->nz = next + 2 * stream_length;
+    next += 3 * stream_length;
+  }
+  if (has_uvs) {
+    streams->u = next;
+    streams->v = next + stream_length;
+  }
+
+  const unsigned char* vertex = vertices;
+  for (size_t i = 0; i < num_vertices; i++, vertex += stride) {
+    const Vec3* pos = (const Vec3*)(vertex + position_offset);
+    streams->x[i] = pos->x;
+    streams->y[i] = pos->y;
+    streams->z[i] = pos->z;
+    if (has_normals) {
+      const Vec3* normal = (const Vec3*)(vertex + normal_offset);
+      streams->nx[i] = normal->x;
+      streams->ny[i] = normal->y;
+      streams->nz[i] = normal->z;
+    }
+    if (has_uvs) {
+      const Vec2* uv = (const Vec2*)(vertex + uv_offset);
+      streams->u[i] = uv->x;
+      streams->v[i] = uv->y;
+    }
+  }
+}
@@ -0,0 +1,38 @@
+#ifndef VERTEX_STREAMS_H_
+#define VERTEX_STREAMS_H_
+
+#include <stddef.h>
+
+#define VERTEX_STREAM_ABSENT ((size_t)-1)
+
+// A structure of arrays copy of a mesh's vertices, one stream per component, for vertex shaders that work on several
+// vertices at once. All streams live in one block, each aligned to and padded to a multiple of 32 bytes. Streams for
+// attributes the vertices don't have are NULL.
+typedef struct
+{
+  size_t num_vertices;
+  float* block;
+  float* x;
+  float* y;
+  float* z;
+  float* nx;
+  float* ny;
+  float* nz;
+  float* u;
+  float* v;
+} VertexStreams;
+
+VertexStreams vertex_streams_make(void);
+void vertex_streams_destroy(VertexStreams* streams);
+
+// Replaces the streams with a copy of `vertices`. The offsets are those of the `Vec3` position, `Vec3` normal and
+// `Vec2` UV members within a vertex, or `VERTEX_STREAM_ABSENT`.
+void vertex_streams_build(VertexStreams* streams,
+                          const void* vertices,
+                          size_t num_vertices,
+                          size_t stride,
+                          size_t position_offset,
+                          size_t normal_offset,
+                          size_t uv_offset);
+
+#endif
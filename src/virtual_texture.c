@@ -0,0 +1,200 @@
+#include "virtual_texture.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define PAGE_NUM_TEXELS (VIRTUAL_TEXTURE_PAGE_SIZE * VIRTUAL_TEXTURE_PAGE_SIZE)
+
+static Texture* virtual_texture_make_fallback(const VirtualTexture* texture);
+static int virtual_texture_find_slot(const VirtualTexture* texture);
+
+VirtualTexture* virtual_texture_make(int width,
+                                     int height,
+                                     size_t num_slots,
+                                     VirtualTexturePageLoader load_page,
+                                     void* source)
+{
+  assert(num_slots > 0);
+
+  VirtualTexture* texture = malloc(sizeof(VirtualTexture));
+  texture->width = width;
+  texture->height = height;
+  texture->pages_x = (width + VIRTUAL_TEXTURE_PAGE_SIZE - 1) / VIRTUAL_TEXTURE_PAGE_SIZE;
+  texture->pages_y = (height + VIRTUAL_TEXTURE_PAGE_SIZE - 1) / VIRTUAL_TEXTURE_PAGE_SIZE;
+  texture->load_page = load_page;
+  texture->source = source;
+
+  const size_t num_pages = (size_t)texture->pages_x * texture->pages_y;
+  texture->page_table = malloc(num_pages * sizeof(int));
+  texture->feedback = calloc(num_pages, sizeof(atomic_uchar));
+  for (size_t i = 0; i < num_pages; i++) {
+    texture->page_table[i] = -1;
+  }
+
+  texture->slots = malloc(num_slots * PAGE_NUM_TEXELS * sizeof(Color));
+  texture->slot_pages = malloc(num_slots * sizeof(int));
+  texture->slot_last_used = calloc(num_slots, sizeof(unsigned long));
+  for (size_t i = 0; i < num_slots; i++) {
+    texture->slot_pages[i] = -1;
+  }
+  texture->num_slots = num_slots;
+  texture->max_loads_per_update = 8;
+  texture->frame = 1;
+
+  texture->fallback = virtual_texture_make_fallback(texture);
+
+  return texture;
+}
+
+void virtual_texture_destroy(VirtualTexture* texture)
+{
+  free(texture->page_table);
+  free(texture->feedback);
+  free(texture->slots);
+  free(texture->slot_pages);
+  free(texture->slot_last_used);
+  texture_destroy(texture->fallback);
+  free(texture);
+}
+
+// Call once per frame, after rendering. Loads at most `max_loads_per_update` pages so that a sudden burst of requests
+// is spread over several frames.
+void virtual_texture_update(VirtualTexture* texture)
+{
+  const int num_pages = texture->pages_x * texture->pages_y;
+
+  // Mark resident pages first, so that they aren't picked for eviction while servicing this frame's misses.
+  for (int page = 0; page < num_pages; page++) {
+    const int slot = texture->page_table[page];
+    if (atomic_load_explicit(&texture->feedback[page], memory_order_relaxed) && slot >= 0) {
+      texture->slot_last_used[slot] = texture->frame;
+      atomic_store_explicit(&texture->feedback[page], 0, memory_order_relaxed);
+    }
+  }
+
+  size_t num_loads = 0;
+  for (int page = 0; page < num_pages; page++) {
+    if (!atomic_load_explicit(&texture->feedback[page], memory_order_relaxed)) continue;
+    atomic_store_explicit(&texture->feedback[page], 0, memory_order_relaxed);
+    if (num_loads == texture->max_loads_per_update) continue;
+
+    const int slot = virtual_texture_find_slot(texture);
+    if (slot < 0) continue;
+
+    if (texture->slot_pages[slot] >= 0) {
+      texture->page_table[texture->slot_pages[slot]] = -1;
+    }
+
+    Color* texels = &texture->slots[(size_t)slot * PAGE_NUM_TEXELS];
+    texture->load_page(texture->source, page % texture->pages_x, page / texture->pages_x, texels);
+
+    texture->slot_pages[slot] = page;
+    texture->slot_last_used[slot] = texture->frame;
+    texture->page_table[page] = slot;
+    num_loads++;
+  }
+
+  texture->frame++;
+}
+
+Color virtual_texture_uv_at(VirtualTexture* texture, float u, float v)
+{
+  assert(u >= 0.0f && u <= 1.0f);
+  assert(v >= 0.0f && v <= 1.0f);
+
+  const int x = u * (texture->width - 1);
+  const int y = v * (texture->height - 1);
+  const int page = (x / VIRTUAL_TEXTURE_PAGE_SIZE) + (y / VIRTUAL_TEXTURE_PAGE_SIZE) * texture->pages_x;
+
+  atomic_store_explicit(&texture->feedback[page], 1, memory_order_relaxed);
+
+  const int slot = texture->page_table[page];
+  if (slot < 0) {
+    return texture_uv_at(texture->fallback, u, v);
+  }
+
+  const int page_offset = (x % VIRTUAL_TEXTURE_PAGE_SIZE) + (y % VIRTUAL_TEXTURE_PAGE_SIZE) * VIRTUAL_TEXTURE_PAGE_SIZE;
+  return texture->slots[(size_t)slot * PAGE_NUM_TEXELS + page_offset];
+}
+
+void virtual_texture_load_page_from_texture(void* source, int page_x, int page_y, Color* texels)
+{
+  const Texture* texture = source;
+
+  const int x_start = page_x * VIRTUAL_TEXTURE_PAGE_SIZE;
+  const int y_start = page_y * VIRTUAL_TEXTURE_PAGE_SIZE;
+
+  for (int y = 0; y < VIRTUAL_TEXTURE_PAGE_SIZE && y_start + y < texture->height; y++) {
+    for (int x = 0; x < VIRTUAL_TEXTURE_PAGE_SIZE && x_start + x < texture->width; x++) {
+      texels[x + y * VIRTUAL_TEXTURE_PAGE_SIZE] = texture_at(texture, x_start + x, y_start + y);
+    }
+  }
+}
+
+// Box-filters the whole texture down to (at most) a single page. The pages are streamed through one at a time, so this
+// never needs more than one page of scratch space.
+static Texture* virtual_texture_make_fallback(const VirtualTexture* texture)
+{
+  const int scale_x = texture->pages_x;
+  const int scale_y = texture->pages_y;
+  const int scale = scale_x > scale_y ? scale_x : scale_y;
+
+  Texture* fallback = texture_make();
+  fallback->width = (texture->width + scale - 1) / scale;
+  fallback->height = (texture->height + scale - 1) / scale;
+  fallback->data = malloc(fallback->width * fallback->height * sizeof(Color));
+
+  const size_t num_fallback_texels = (size_t)fallback->width * fallback->height;
+  unsigned long* sums = calloc(4 * num_fallback_texels, sizeof(unsigned long));
+  unsigned long* counts = calloc(num_fallback_texels, sizeof(unsigned long));
+  Color* page_texels = malloc(PAGE_NUM_TEXELS * sizeof(Color));
+
+  for (int page_y = 0; page_y < texture->pages_y; page_y++) {
+    for (int page_x = 0; page_x < texture->pages_x; page_x++) {
+      texture->load_page(texture->source, page_x, page_y, page_texels);
+
+      for (int y = 0; y < VIRTUAL_TEXTURE_PAGE_SIZE; y++) {
+        const int ty = page_y * VIRTUAL_TEXTURE_PAGE_SIZE + y;
+        if (ty >= texture->height) break;
+
+        for (int x = 0; x < VIRTUAL_TEXTURE_PAGE_SIZE; x++) {
+          const int tx = page_x * VIRTUAL_TEXTURE_PAGE_SIZE + x;
+          if (tx >= texture->width) break;
+
+          const size_t index = tx / scale + (size_t)(ty / scale) * fallback->width;
+          const Color texel = page_texels[x + y * VIRTUAL_TEXTURE_PAGE_SIZE];
+          for (int c = 0; c < 4; c++) {
+            sums[4 * index + c] += (texel >> (24 - 8 * c)) & 0xff;
+          }
+          counts[index]++;
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < num_fallback_texels; i++) {
+    Color average = 0;
+    for (int c = 0; c < 4; c++) {
+      average |= (Color)(sums[4 * i + c] / counts[i]) << (24 - 8 * c);
+    }
+    fallback->data[i] = average;
+  }
+
+  free(sums);
+  free(counts);
+  free(page_texels);
+  return fallback;
+}
+
+// Returns an empty slot if there is one, otherwise the least recently used slot that wasn't used this frame.
+static int virtual_texture_find_slot(const VirtualTexture* texture)
+{
+  int best = -1;
+  for (size_t i = 0; i < texture->num_slots; i++) {
+    if (texture->slot_pages[i] < 0) return i;
+    if (texture->slot_last_used[i] >= texture->frame) continue;
+    if (best < 0 || texture->slot_last_used[i] < texture->slot_last_used[best]) best = i;
+  }
+  return best;
+}
@@ -0,0 +1,53 @@
+#ifndef VIRTUAL_TEXTURE_H_
+#define VIRTUAL_TEXTURE_H_
+
+#include "graphics.h"
+#include "texture.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define VIRTUAL_TEXTURE_PAGE_SIZE 128
+
+// Fills `texels` (row-major, `VIRTUAL_TEXTURE_PAGE_SIZE` squared) with the contents of the given page. Texels that fall
+// outside of the texture are never sampled.
+typedef void (*VirtualTexturePageLoader)(void* source, int page_x, int page_y, Color* texels);
+
+// A texture that is only partially resident. Its pages are decoded on demand into a fixed number of physical page
+// slots, so memory use depends on the slot count rather than the texture size. Sampling a page records it in the
+// feedback buffer, which is why sampling takes a mutable texture; the writes are relaxed atomic stores, so any number
+// of threads may sample at once. `virtual_texture_update` then makes the requested pages resident, evicting the least
+// recently sampled ones, and must not run while others sample. Until a page is resident, samples come from a low
+// resolution copy of the whole texture.
+typedef struct
+{
+  int width;
+  int height;
+  int pages_x;
+  int pages_y;
+  VirtualTexturePageLoader load_page;
+  void* source;
+  int* page_table;          // Physical slot of each virtual page, or -1
+  atomic_uchar* feedback;  // Non-zero for every virtual page sampled since the last update
+  Color* slots;             // `num_slots` pages of texels
+  int* slot_pages;          // Virtual page held by each slot, or -1
+  unsigned long* slot_last_used;
+  size_t num_slots;
+  size_t max_loads_per_update;
+  Texture* fallback;
+  unsigned long frame;
+} VirtualTexture;
+
+VirtualTexture* virtual_texture_make(int width,
+                                     int height,
+                                     size_t num_slots,
+                                     VirtualTexturePageLoader load_page,
+                                     void* source);
+void virtual_texture_destroy(VirtualTexture* texture);
+void virtual_texture_update(VirtualTexture* texture);
+Color virtual_texture_uv_at(VirtualTexture* texture, float u, float v);
+
+// Page loader that reads from a regular (typically block-compressed) texture.
+void virtual_texture_load_page_from_texture(void* source, int page_x, int page_y, Color* texels);
+
+#endif